@@ -8,6 +8,7 @@
 #include<SyntaxType.h>
 #include<stringUtil.h>
 #include"parserGen.h"
+#include"parseTableFile.h"
 #include"TypingSystem.h"
 namespace AST {
 
@@ -185,8 +186,9 @@ public :
 class TermSymNode : public ASTNode
 {
 public:
-    std::u8string token_type;
-    std::u8string value;
+    std::u8string_view token_type; //指向词法器静态字符串
+    std::u8string_view value;      //指向TokenList持有的源码缓冲区
+    std::optional<Lexer::TokenLiteral> literal; //NUM/FLO扫描时转换好的数值
     TermSymNode(/* args */);
     ~TermSymNode();
     inline void accept(ASTVisitor& visitor) override {
@@ -238,6 +240,11 @@ inline NonTermProdNode::~NonTermProdNode()
 {
 }
 
+/**
+ * @brief 建立词法kind到文法终结符SymbolId的映射，无对应终结符的kind（如ERR）为nullopt
+ */
+std::vector<std::optional<SymbolId>> buildTokenKindMap(const SymbolTable & symtab);
+
 class AbstractSyntaxTree {
 public:
     unique_ptr<ASTNode> root;
@@ -246,15 +253,73 @@ public:
     const std::vector<std::unordered_map<SymbolId, action>> actionTable;
     const SymbolTable symtab;
     const std::unordered_map<ProductionId, Production> Productions;
+    const std::vector<std::optional<SymbolId>> tokenKindSymbol; //下标为Lexer::TokenKind
+    const ParseTable parseTable;    //LR驱动所用的压缩表
+    const std::shared_ptr<const LCMPFileIO::ParseTableFile> tableFile; //由二进制分析表构造时，states等哈希表为空
+    /**
+     * @brief 一次分析的移进/归约步数
+     */
+    struct ParseSteps {
+        size_t shifts = 0;
+        size_t reduces = 0;
+        size_t defaultReduces = 0;  //其中不查向前看的默认归约
+    };
+    ParseSteps steps;   //最近一次BuildSpecifiedAST
     AbstractSyntaxTree() = delete;
     inline AbstractSyntaxTree(ASTbaseContent inp)
-     : states(std::move(inp.states)),gotoTable(std::move(inp.gotoTable)), actionTable(std::move(inp.actionTable)), symtab(std::move(inp.symtab)), Productions(std::move(inp.Productions))
+     : states(std::move(inp.states)),gotoTable(std::move(inp.gotoTable)), actionTable(std::move(inp.actionTable)), symtab(std::move(inp.symtab)), Productions(std::move(inp.Productions)),
+       tokenKindSymbol(buildTokenKindMap(symtab)),
+       parseTable(ParseTable::build(actionTable,gotoTable,symtab,Productions))
     {
         root = nullptr;
     }
-    bool BuildCommonAST(const std::vector<Lexer::scannerToken_t> & tokens);
-    bool BuildSpecifiedAST(const std::vector<Lexer::scannerToken_t> & tokens);
+    /**
+     * @brief 直接使用映射的二进制分析表，不构造哈希表形式的ACTION/GOTO表
+     */
+    inline AbstractSyntaxTree(std::shared_ptr<const LCMPFileIO::ParseTableFile> file)
+     : symtab(file->symbols()), Productions(file->productions()),
+       tokenKindSymbol(buildTokenKindMap(symtab)),
+       parseTable(file->table()), tableFile(std::move(file))
+    {
+        root = nullptr;
+    }
+    /**
+     * @brief 状态的项目集，仅用于报错；来自二进制分析表时此时才解码
+     */
+    std::vector<dotProdc> stateItems(StateId state) const;
+    /**
+     * @brief 此后BuildSpecifiedAST改用默认归约与单产生式旁路后的分析表，BuildCommonAST不受影响
+     */
+    ParseTable::OptimizeStats optimizeParseTable();
+    bool BuildCommonAST(const Lexer::TokenList & tokens);
+    bool BuildSpecifiedAST(const Lexer::TokenList & tokens);
+    /**
+     * @brief 边扫描边分析，不生成token数组
+     * @attention AST中的字符串视图指向tokens.sourceBuffer()，需在AST使用期间保持其存活
+     */
+    bool BuildSpecifiedAST(Lexer::TokenStream & tokens);
+    /**
+     * @brief 扫描在独立线程进行，与移进/归约及AST结点构造重叠
+     */
+    bool BuildSpecifiedAST(Lexer::PipelinedTokenStream & tokens);
+    /**
+     * @brief 当前分析表与构建时生成的直接编码分析器出自同一组文法文件与LR模式，按文法指纹判断
+     */
+    bool hasDirectParser() const;
+    /**
+     * @brief 用直接编码的分析器（每个状态一个case）代替查表，AST的构造与BuildSpecifiedAST相同
+     * @throws std::runtime_error 当前文法不是内置默认文法
+     */
+    bool BuildSpecifiedASTDirect(const Lexer::TokenList & tokens);
+    bool BuildSpecifiedASTDirect(Lexer::TokenStream & tokens);
+    bool BuildSpecifiedASTDirect(Lexer::PipelinedTokenStream & tokens);
     virtual ~AbstractSyntaxTree() = default;
+private:
+    ParseTable optimizedTable;  //未优化时为空表
+    template<typename TokenCursor>
+    bool BuildSpecifiedASTImpl(TokenCursor & tokens);
+    template<typename TokenCursor>
+    bool BuildSpecifiedASTDirectImpl(TokenCursor & tokens);
 };
 
 class mVisitor : public ASTVisitor {
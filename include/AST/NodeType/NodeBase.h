@@ -88,6 +88,13 @@ public:
     }
     static constexpr std::array<std::u8string_view,2> SupportProd=
     {u8"Dimensions -> [ num ]",u8"Dimensions -> Dimensions [ num ]" };
+    //num终结符在扫描时已转换为整数
+    inline static int numLiteral(const TermSymNode * term) {
+        if(!term->literal) {
+            throw std::out_of_range("数组维度无法表示: " + toString(term->value));
+        }
+        return std::get<int>(term->literal.value());
+    }
     inline static unique_ptr<ASTNode> try_constructS(ASTNode * as , AbstractSyntaxTree * astTree) {
         auto * NonTnode = dynamic_cast<NonTermProdNode *>(as);
         if(!NonTnode) {
@@ -116,7 +123,7 @@ public:
             assert(dynamic_cast<TermSymNode*>(NonTnode->childs[1].get())->token_type == u8"NUM");
 
             auto newNode = std::make_unique<Dimensions>();
-            newNode->array_len_vec.push_back(std::stoi(toString(static_cast<TermSymNode*>(NonTnode->childs[1].get())->value)));
+            newNode->array_len_vec.push_back(numLiteral(static_cast<TermSymNode*>(NonTnode->childs[1].get())));
             return newNode;
         }
         case 1:
@@ -127,7 +134,7 @@ public:
             assert(dynamic_cast<TermSymNode*>(NonTnode->childs[2].get())->token_type == u8"NUM");
             unique_ptr<Dimensions> stoleNode;
             stoleNode.reset(static_cast<Dimensions *>(NonTnode->childs[0].release()));
-            stoleNode->array_len_vec.push_back(std::stoi(toString(static_cast<TermSymNode*>(NonTnode->childs[2].get())->value)));
+            stoleNode->array_len_vec.push_back(numLiteral(static_cast<TermSymNode*>(NonTnode->childs[2].get())));
             return stoleNode;
         }
         default:
@@ -14,6 +14,9 @@ public:
     static constexpr std::array<std::u8string_view,5> SupportProd=
     {u8"Type -> BaseType", u8"Type -> Type *",  
     u8"BaseType -> int",u8"BaseType -> float",u8"BaseType -> void "};
+    //构造时原样返回唯一子结点的单产生式，分析表优化可跳过其归约
+    static constexpr std::array<std::u8string_view,1> ForwardProd=
+    {u8"Type -> BaseType"};
     pType() {
         this->Ntype = ASTType::pType;
         this->subType = ASTSubType::pType;
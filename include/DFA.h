@@ -5,6 +5,9 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
+#include <array>
+#include <type_traits>
+#include <cstdint>
 #include <stdexcept>
 #include <optional>
 #include <memory>
@@ -78,6 +81,34 @@ public:
     }
 };
 
+/**
+ * @brief 扁平数组形式的字节DFA
+ * @note 输入字节先经classOf压缩为字符类，再查 状态数 × 字符类数 的转移表；
+ *       acceptTag为每个状态的接受标记，-1表示非接受状态；dead(-1)表示无转移
+ */
+template <typename StateIDType = int16_t>
+requires std::is_signed_v<StateIDType>
+class DenseDFA {
+public:
+    static constexpr StateIDType dead = -1;
+    std::array<uint8_t,256> classOf{};
+    size_t classCount = 0;
+    std::vector<StateIDType> table;
+    std::vector<int32_t> acceptTag;
+    StateIDType initial = 0;
+
+    inline size_t stateCount() const { return acceptTag.size(); }
+    inline StateIDType next(StateIDType state, uint8_t ch) const {
+        return table[static_cast<size_t>(state) * classCount + classOf[ch]];
+    }
+    inline StateIDType nextByClass(StateIDType state, size_t cls) const {
+        return table[static_cast<size_t>(state) * classCount + cls];
+    }
+    inline size_t tableBytes() const {
+        return table.size() * sizeof(StateIDType) + sizeof(classOf);
+    }
+};
+
 inline void DFA_test_main() {
 
     DFA<int, int> dfa(0, {2});  // 初始状态 0，接受状态 2
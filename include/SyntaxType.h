@@ -47,6 +47,25 @@ struct ForceReducedProd {
     std::u8string sym;
 };
 
+/**
+ * @brief 文法文件中%left/%right/%nonassoc声明的结合性
+ */
+enum class Assoc {
+    Left,
+    Right,
+    NonAssoc,
+};
+
+/**
+ * @brief 终结符的优先级，同一行声明的终结符同级，越靠后的行越高（从1开始）
+ */
+struct Precedence {
+    int level;
+    Assoc assoc;
+};
+
+using PrecedenceTable = std::unordered_map<SymbolId, Precedence>;
+
 
 class SymbolTable;
 
@@ -96,10 +115,10 @@ public:
         return symbols_[static_cast<SymbolId>(index)];
     }
     std::optional<SymbolId> find_index(const std::u8string& sym) const;
-    std::vector<SymbolId> find_index_type(const std::u8string& type) const;
+    std::vector<SymbolId> find_index_type(std::u8string_view type) const;
     //SymbolId tokenToId(Lexer::scannerToken_t token) const;
     //std::optional<SymbolId> find_index_type(const std::u8string& type) const;
-    inline const auto & symbols() { return symbols_; }
+    inline const auto & symbols() const { return symbols_; }
     inline const auto & nonTerminals() const {return nonTerminalId;}
 };
 
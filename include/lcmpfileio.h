@@ -74,6 +74,10 @@ namespace LCMPFileIO
             bool isTerminal_,size_t index_) {
             return Symbol(sym_,token_type_,pattern_,isTerminal_,index_);
         }
+        /**
+         * @brief 产生式编号的全局计数，同一进程内多次生成分析表前清零，编号才与单独运行一致
+         */
+        inline static size_t & productionCounter() { return Production::next_index_; }
         inline static Production Production_Construct_helper(NonTerminalId lhs_index_ , std::vector<SymbolId> rhs_indices_ , ProductionId index_) {
             Production::next_index_++;
             return Production(lhs_index_,rhs_indices_,index_);
@@ -144,6 +148,10 @@ void from_json(const nlohmann::json& j, ASTbaseContent& obj);
 namespace LCMPFileIO
 {
 
+    /**
+     * @brief 拆分terminal.txt的一行 "type","name"[,"pattern"]，空行与注释行返回空
+     */
+    std::vector<std::string> splitTerminalLine(std::string line);
     U8StrProduction parseProduction(const std::u8string_view& line);
     ForceReducedProd parseProductionR(const std::u8string& line);
     std::vector<ForceReducedProd> parseProdFileR (const std::filesystem::path & inputPath);
@@ -164,6 +172,12 @@ void readTerminals(SymbolTable & symtable,std::filesystem::path terminalPath);
 
 void readProductionRule(SymbolTable & symtable,std::vector<Production> & productions , std::filesystem::path rulePath);
 
+/**
+ * @brief 读取文法文件中的优先级声明行：%left|%right|%nonassoc 终结符...
+ * @throws std::runtime_error 无法打开文件，或声明了未知的终结符
+ */
+PrecedenceTable readPrecedence(const SymbolTable & symtable, std::filesystem::path rulePath);
+
 inline std::string readFileToString(const std::filesystem::path& filePath) {
     std::ifstream file(filePath, std::ios::binary | std::ios::ate);
     if (!file) {
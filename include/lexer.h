@@ -2,22 +2,339 @@
 #define LCMP_LEXER_HEADER
 
 #include<string>
+#include<string_view>
 #include<vector>
+#include<memory>
+#include<cstdint>
+#include<variant>
+#include<optional>
+#include<array>
+#include<functional>
+#include<atomic>
+#include<thread>
+#include"spscRing.h"
+#include"lexerGen.h"
+#include"sourceFile.h"
 
 namespace Lexer
 {
+    /**
+     * @brief 稠密整数token种类，与token类型名（如"ID"）一一对应
+     */
+    using TokenKind = uint16_t;
+    //保留kind，其余kind在词法器初始化时按类型名出现顺序分配
+    inline constexpr TokenKind kindEND = 0;
+    inline constexpr TokenKind kindERR = 1;
+    inline constexpr TokenKind kindSKIP = 2;
+    inline constexpr TokenKind kindEOF = 3;
+
+    /**
+     * @brief 源码缓冲区，TokenList与token流共同持有，token的value均为其上的视图
+     */
+    using SourcePtr = std::shared_ptr<const LCMPFileIO::SourceFile>;
+
+    /**
+     * @brief NUM/FLO在扫描时一次性转换的数值
+     */
+    using TokenLiteral = std::variant<int,float>;
+
+    /**
+     * @brief token，type与value均为视图
+     * @attention value指向TokenList持有的源码缓冲区，type指向词法器内部的静态字符串，勿在TokenList析构后使用
+     */
     typedef struct scannerToken_t
     {
-        std::u8string type;
-        std::u8string value;
+        TokenKind kind;
+        std::u8string_view type;
+        std::u8string_view value;
     }scannerToken_t;
 
-    std::vector<scannerToken_t> scan(const std::u8string & u8input);
+    /**
+     * @brief 扫描结果，持有整个源码缓冲区（文件映射或唯一一份拷贝）
+     * @note token按列存储：kind、起始偏移、长度各一数组，每个token 10字节；
+     *       另存每行起始偏移用于定位行列，NUM/FLO的数值存于按token下标排序的旁路数组
+     */
+    class TokenList {
+    private:
+        SourcePtr source_;
+        std::vector<TokenKind> kinds_;
+        std::vector<uint32_t> begins_;
+        std::vector<uint32_t> lengths_;
+        std::vector<uint32_t> lineStarts_;
+        std::vector<uint32_t> literalTokens_;   //有数值的token下标，升序
+        std::vector<TokenLiteral> literals_;
+        std::shared_ptr<const std::vector<std::u8string>> kindNames_;  //产生该列表的Scanner的kind名
+        friend class Scanner;
+    public:
+        class const_iterator {
+        private:
+            const TokenList * list_ = nullptr;
+            size_t index_ = 0;
+        public:
+            using value_type = scannerToken_t;
+            using difference_type = std::ptrdiff_t;
+            const_iterator() = default;
+            inline const_iterator(const TokenList * list, size_t index) : list_(list), index_(index) {}
+            inline scannerToken_t operator*() const { return (*list_)[index_]; }
+            inline const_iterator & operator++() { index_++; return *this; }
+            inline const_iterator operator++(int) { auto tmp = *this; index_++; return tmp; }
+            inline bool operator==(const const_iterator & other) const { return index_ == other.index_; }
+        };
+
+        TokenList() = default;
+
+        inline size_t size() const { return kinds_.size(); }
+        inline TokenKind kind(size_t i) const { return kinds_[i]; }
+        /**
+         * @brief 组装第i个token，END的value为"$"
+         */
+        scannerToken_t operator[](size_t i) const;
+        inline scannerToken_t back() const { return (*this)[size() - 1]; }
+        inline const_iterator begin() const { return const_iterator(this,0); }
+        inline const_iterator end() const { return const_iterator(this,size()); }
+        inline std::u8string_view source() const {
+            return source_ ? source_->view() : std::u8string_view();
+        }
+        inline SourcePtr sourceBuffer() const { return source_; }
+        inline size_t offset(size_t i) const { return begins_[i]; }
+        /**
+         * @brief 第i个token所在行列，从1开始
+         */
+        size_t line(size_t i) const;
+        size_t column(size_t i) const;
+        /**
+         * @brief 第i个token的数值，非NUM/FLO或越界时为nullopt
+         */
+        std::optional<TokenLiteral> literal(size_t i) const;
+        /**
+         * @brief token数组与行表占用的字节数（不含源码）
+         */
+        size_t memoryBytes() const;
+    };
+
+    /**
+     * @brief 对源码的一次编辑：将[offset,offset+removed)替换为inserted
+     */
+    struct TextEdit {
+        size_t offset = 0;
+        size_t removed = 0;
+        std::u8string_view inserted;
+    };
+
+    /**
+     * @brief 一次增量重扫的范围，用于观察代价
+     */
+    struct RelexResult {
+        size_t rescanBegin = 0;     //新源码中重扫的起止偏移
+        size_t rescanEnd = 0;
+        size_t removedTokens = 0;
+        size_t insertedTokens = 0;
+    };
+
+    /**
+     * @brief 不可变扫描器：构造时由词法规则生成DFA及各状态的附属信息，之后只读
+     * @note scan不修改任何共享状态，同一个Scanner可被多个线程同时使用，无需加锁；
+     *       不同Scanner各自分配kind，互不影响
+     */
+    class Scanner {
+    public:
+        explicit Scanner(const std::vector<LexerGen::LexRule> & rules);
+        /**
+         * @attention 末尾附加[END,$]
+         */
+        TokenList scan(std::u8string u8input) const;
+        /**
+         * @brief 直接在source的视图上扫描（如文件映射），不拷贝源码
+         */
+        TokenList scan(SourcePtr source) const;
+        /**
+         * @brief 并行扫描：在安全同步点切分缓冲区，各段由线程并行扫描后按序拼接，结果与scan逐字节一致
+         * @param threadCount 0表示取硬件线程数；输入较小时退化为scan
+         */
+        TokenList scanParallel(std::u8string u8input, size_t threadCount = 0) const;
+        TokenList scanParallel(SourcePtr source, size_t threadCount = 0) const;
+        /**
+         * @brief 增量重扫：从编辑点之前最近的同步字节起重扫，直到新token与旧列表重新对齐，其后的token只平移偏移
+         * @param tokens 须由本扫描器产生，原地更新为编辑后源码的扫描结果，与scan逐token一致
+         * @note 只有重扫的字节数取决于编辑大小；整体仍为O(n)：新源码整段拷贝到重新分配的缓冲区（token以视图引用连续的源码），
+         *       编辑点之后的token、字面量与行首表逐项平移；旧缓冲区仍由其他持有者保活
+         * @throws std::invalid_argument 编辑越界或列表不属于本扫描器
+         */
+        RelexResult relex(TokenList & tokens, const TextEdit & edit) const;
+        /**
+         * @brief kind总数，kind取值为[0,kindCount())
+         */
+        size_t kindCount() const;
+        std::u8string_view kindName(TokenKind kind) const;
+        /**
+         * @brief 使用构建时嵌入的grammar/terminal.txt的扫描器，首次调用时构建（线程安全）
+         */
+        static const Scanner & defaultScanner();
+    private:
+        static constexpr TokenKind noKind = 0xFFFF;
+        //自环字节集合覆盖[0-9]或[a-zA-Z0-9]的状态（如ID、NUM体），可批量跳过
+        enum class SelfLoop : uint8_t {
+            None,
+            Digit,
+            Alnum,
+        };
+        struct Step {
+            TokenKind kind;
+            size_t next_start;
+        };
+        LexerGen::LexerTables tables_;
+        std::shared_ptr<const std::vector<std::u8string>> kindNames_;
+        std::vector<TokenKind> stateKind_;  //每个DFA状态接受的kind，非接受状态为noKind
+        std::vector<SelfLoop> stateLoop_;
+        std::vector<char> stateKeyword_;    //该状态接受的规则兼收关键字，词素需再查关键字表
+        std::vector<TokenKind> ruleKind_;
+        TokenKind numKind_ = noKind;        //需要转换数值的kind，规则中不存在时为noKind
+        TokenKind floKind_ = noKind;
+        bool skipSpaceRun_ = false;         //空白串可整段跳过
+        //除起始状态外任何状态读入都进入死状态的字节：token只能从这里开始，可作并行切分点
+        std::array<bool,256> syncByte_{};
+        Step matchToken(std::u8string_view input, size_t start_index) const;
+        TokenList beginList(SourcePtr && source) const;
+        /**
+         * @brief 扫描input[start,input.size())中的token追加到out，input需截止于同步点或缓冲区末尾
+         */
+        void scanRange(std::u8string_view input, size_t start, TokenList & out) const;
+        void finishList(TokenList & out) const;
+        void emitToken(TokenList & out, TokenKind kind, size_t begin, std::u8string_view text) const;
+        std::optional<TokenLiteral> parseLiteral(TokenKind kind, std::u8string_view text) const;
+        /**
+         * @brief 校验编码与大小后接管源码
+         */
+        SourcePtr adoptSource(SourcePtr && source) const;
+        friend class TokenStream;
+    };
+
+    /**
+     * @brief 拉取式token流：每次只向前扫描一个token，不生成token数组
+     * @note 流末尾为[END,$]，之后peek一直停留在END；
+     *       token的value指向sourceBuffer()，在其存活期间有效
+     */
+    class TokenStream {
+    public:
+        using Observer = std::function<void(const scannerToken_t & token, size_t index)>;
+        explicit TokenStream(std::u8string u8input);   //使用Scanner::defaultScanner()
+        TokenStream(const Scanner & scanner, std::u8string u8input);
+        explicit TokenStream(SourcePtr source);
+        TokenStream(const Scanner & scanner, SourcePtr source);
+
+        inline const scannerToken_t & peek() const { return current_; }
+        /**
+         * @brief 返回当前token并前进一个
+         */
+        scannerToken_t next();
+        /**
+         * @brief 当前token的序号、行列（从1开始）与数值
+         */
+        inline size_t index() const { return index_; }
+        inline size_t line() const { return line_; }
+        inline size_t column() const { return begin_ - lineStart_ + 1; }
+        inline const std::optional<TokenLiteral> & literal() const { return literal_; }
+        inline SourcePtr sourceBuffer() const { return source_; }
+        /**
+         * @brief 每个token成为当前token时回调（含END），用于边分析边输出token
+         */
+        void setObserver(Observer observer);
+    private:
+        const Scanner & scanner_;
+        SourcePtr source_;
+        scannerToken_t current_;
+        std::optional<TokenLiteral> literal_;
+        size_t index_ = 0;
+        size_t begin_ = 0;      //当前token起点
+        size_t pos_ = 0;        //下一次扫描起点
+        size_t line_ = 1;
+        size_t lineStart_ = 0;
+        size_t countedTo_ = 0;  //换行已统计到的位置
+        Observer observer_;
+        void advance();
+    };
+
+    /**
+     * @brief 以下均作用于Scanner::defaultScanner()
+     */
+    TokenList scan(std::u8string u8input);
+    TokenList scan(SourcePtr source);
+    RelexResult relex(TokenList & tokens, const TextEdit & edit);
+    size_t kindCount();
+    std::u8string_view kindName(TokenKind kind);
     int test_main_u8();
-    
+    int test_main_lexbench();
+    int test_main_threads();
+    int test_main_relex();
+
+    /**
+     * @brief 流水线模式的统计，用于判断扫描与分析哪一端是瓶颈
+     * @note 阻塞次数按等待事件计：生产者遇到环满、消费者遇到环空各记一次
+     */
+    struct PipelineStats {
+        uint64_t batches = 0;
+        uint64_t producerStalls = 0;
+        uint64_t consumerStalls = 0;
+    };
+
+    /**
+     * @brief 独立线程扫描，按批经SPSC环形缓冲交给分析线程，接口与TokenStream相同
+     * @note 只能由一个线程消费；析构时通知扫描线程停止并等待其退出。
+     *       observer在扫描线程上调用，须在构造时给出
+     */
+    class PipelinedTokenStream {
+    public:
+        static constexpr size_t batchSize = 256;
+        explicit PipelinedTokenStream(std::u8string u8input, TokenStream::Observer observer = {}, size_t ringBatches = 16);
+        PipelinedTokenStream(const Scanner & scanner, std::u8string u8input, TokenStream::Observer observer = {}, size_t ringBatches = 16);
+        explicit PipelinedTokenStream(SourcePtr source, TokenStream::Observer observer = {}, size_t ringBatches = 16);
+        PipelinedTokenStream(const Scanner & scanner, SourcePtr source, TokenStream::Observer observer = {}, size_t ringBatches = 16);
+        ~PipelinedTokenStream();
+        PipelinedTokenStream(const PipelinedTokenStream &) = delete;
+        PipelinedTokenStream & operator=(const PipelinedTokenStream &) = delete;
+
+        inline const scannerToken_t & peek() const { return item().token; }
+        scannerToken_t next();
+        inline size_t index() const { return index_; }
+        inline size_t line() const { return item().line; }
+        inline size_t column() const { return item().column; }
+        inline const std::optional<TokenLiteral> & literal() const { return item().literal; }
+        inline SourcePtr sourceBuffer() const { return source_; }
+        /**
+         * @brief 生产者计数在扫描线程结束前可能仍在增长
+         */
+        PipelineStats stats() const;
+    private:
+        struct Item {
+            scannerToken_t token;
+            size_t line;
+            size_t column;
+            std::optional<TokenLiteral> literal;
+        };
+        struct Batch {
+            std::array<Item,batchSize> items;
+            size_t count = 0;
+            bool last = false;  //含END的批次
+        };
+        TokenStream stream_;    //构造后只由扫描线程访问
+        SourcePtr source_;
+        SpscRing<Batch> ring_;
+        Batch * batch_ = nullptr;   //消费者当前持有的批次
+        size_t pos_ = 0;
+        size_t index_ = 0;
+        uint64_t batches_ = 0;
+        uint64_t consumerStalls_ = 0;
+        std::atomic<uint64_t> producerStalls_{0};
+        std::jthread producer_;
+
+        inline const Item & item() const { return batch_->items[pos_]; }
+        void produce(std::stop_token stop);
+        void fetch();
+    };
+
 } // namespace Lexer
 
 
 
 
-#endif
\ No newline at end of file
+#endif
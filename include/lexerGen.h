@@ -0,0 +1,214 @@
+#ifndef LCMP_LEXERGEN_HEADER
+#define LCMP_LEXERGEN_HEADER
+#include<string>
+#include<string_view>
+#include<vector>
+#include<filesystem>
+#include<array>
+#include<cstdint>
+#include"DFA.h"
+
+/**
+ * 词法器生成：terminal.txt规则 -> Thompson NFA -> 子集构造DFA -> Hopcroft最小化 -> 字符类压缩的稠密转移表
+ *
+ * 模式记法（本项目约定）：
+ *   a|b 选择，(...) 分组，* + ? 闭包，[a-z0-9] / [^...] 字符类，
+ *   \x80 十六进制字节，\n \t \r 及 \c 转义任意字符；
+ *   字符类外的空白忽略，"."按字面匹配
+ */
+namespace LexerGen
+{
+
+struct LexRule {
+    std::u8string type;     //token类型，如"ID"
+    std::u8string pattern;  //模式，terminal.txt无模式列时为转义后的字面量
+};
+
+/**
+ * @brief 关键字完美哈希表：关键字 -> 规则下标，一次探测即可判定
+ * @note 可在编译期构造；seed从1起递增搜索，直到所有关键字落入互不相同的槽位
+ */
+class KeywordTable {
+public:
+    static constexpr size_t maxKeywords = 64;
+    static constexpr size_t maxLength = 15;
+
+    struct Keyword {
+        std::array<char8_t,maxLength> text{};
+        uint8_t length = 0;
+        int16_t rule = -1;
+        constexpr std::u8string_view view() const { return {text.data(),length}; }
+    };
+
+    /**
+     * @brief 追加关键字，表满、过长或重复时返回false（重复时保留先加入的规则）
+     */
+    constexpr bool add(std::u8string_view word, int16_t rule) {
+        if(count_ == maxKeywords || word.empty() || word.size() > maxLength || find(word) != -1) {
+            return false;
+        }
+        Keyword & k = keys_[count_++];
+        for(size_t i = 0 ; i < word.size() ; i++) k.text[i] = word[i];
+        k.length = static_cast<uint8_t>(word.size());
+        k.rule = rule;
+        if(k.length > longest_) longest_ = k.length;
+        return true;
+    }
+    /**
+     * @brief 搜索无冲突的seed，失败时返回false
+     */
+    constexpr bool build() {
+        for(size_t slots = minSlots() ; slots <= maxSlots ; slots *= 2) {
+            for(uint32_t seed = 1 ; seed <= maxSeedTries ; seed++) {
+                if(tryPlace(seed,slots)) return true;
+            }
+        }
+        return false;
+    }
+    /**
+     * @return 关键字对应的规则下标，非关键字返回-1
+     */
+    constexpr int lookup(std::u8string_view word) const {
+        if(word.size() > longest_ || slotCount_ == 0) return -1;
+        int8_t idx = slots_[hash(word,seed_) & (slotCount_ - 1)];
+        if(idx < 0 || keys_[idx].view() != word) return -1;
+        return keys_[idx].rule;
+    }
+    constexpr size_t size() const { return count_; }
+    constexpr const Keyword & operator[](size_t i) const { return keys_[i]; }
+    constexpr uint32_t seed() const { return seed_; }
+    constexpr size_t slotCount() const { return slotCount_; }
+
+private:
+    static constexpr size_t maxSlots = 8 * maxKeywords;
+    static constexpr uint32_t maxSeedTries = 4096;
+    std::array<Keyword,maxKeywords> keys_{};
+    std::array<int8_t,maxSlots> slots_{};   //关键字下标，空槽为-1
+    size_t count_ = 0;
+    size_t slotCount_ = 0;
+    uint32_t seed_ = 0;
+    uint8_t longest_ = 0;
+
+    //带seed的FNV-1a
+    static constexpr uint32_t hash(std::u8string_view word, uint32_t seed) {
+        uint32_t h = 2166136261u ^ seed;
+        for(char8_t c : word) {
+            h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        return h ^ (h >> 15);
+    }
+    constexpr size_t minSlots() const {
+        size_t slots = 4;
+        while(slots < 2 * count_) slots *= 2;
+        return slots;
+    }
+    constexpr int find(std::u8string_view word) const {
+        for(size_t i = 0 ; i < count_ ; i++) {
+            if(keys_[i].view() == word) return static_cast<int>(i);
+        }
+        return -1;
+    }
+    constexpr bool tryPlace(uint32_t seed, size_t slots) {
+        for(size_t i = 0 ; i < slots ; i++) slots_[i] = -1;
+        for(size_t i = 0 ; i < count_ ; i++) {
+            auto & slot = slots_[hash(keys_[i].view(),seed) & (slots - 1)];
+            if(slot != -1) return false;
+            slot = static_cast<int8_t>(i);
+        }
+        seed_ = seed;
+        slotCount_ = slots;
+        return true;
+    }
+};
+
+/**
+ * @brief 模式仅由字母、数字及\x80以上字节组成时即为其字面量本身，可作为关键字候选
+ */
+constexpr bool isPlainWord(std::u8string_view pattern) {
+    if(pattern.empty() || pattern.size() > KeywordTable::maxLength) return false;
+    for(char8_t c : pattern) {
+        bool word = ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c >= 0x80;
+        if(!word) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 编译期从terminal.txt文本取关键字候选并构造完美哈希
+ * @note 行与规则下标的对应关系同parseLexRules；候选能否真正移出DFA由generate核对
+ */
+constexpr KeywordTable keywordsFromTerminals(std::string_view text) {
+    KeywordTable table;
+    int16_t rule = 0;
+    size_t pos = 0;
+    while(pos < text.size()) {
+        size_t eol = text.find('\n',pos);
+        if(eol == std::string_view::npos) eol = text.size();
+        std::string_view line = text.substr(pos,eol - pos);
+        pos = eol + 1;
+        if(line.find("//") != std::string_view::npos) {
+            line = line.substr(0,line.find("//"));
+        }
+        std::array<std::string_view,3> fields{};
+        size_t fieldCount = 0;
+        size_t start = 0;
+        while(true) {
+            size_t q1 = line.find('"',start);
+            if(q1 == std::string_view::npos) break;
+            size_t q2 = line.find('"',q1 + 1);
+            if(q2 == std::string_view::npos) break;
+            if(fieldCount < fields.size()) fields[fieldCount] = line.substr(q1 + 1,q2 - q1 - 1);
+            fieldCount++;
+            start = q2 + 1;
+        }
+        if(fieldCount < 2) continue;
+        if((fieldCount == 2 || fields[2].empty()) && fields[1].size() <= KeywordTable::maxLength) {
+            //常量求值中不能reinterpret_cast，逐字节拷出
+            std::array<char8_t,KeywordTable::maxLength> buf{};
+            for(size_t i = 0 ; i < fields[1].size() ; i++) buf[i] = static_cast<char8_t>(fields[1][i]);
+            std::u8string_view word(buf.data(),fields[1].size());
+            if(isPlainWord(word)) table.add(word,rule);
+        }
+        rule++;
+    }
+    table.build();
+    return table;
+}
+
+struct LexerStats {
+    size_t nfaStates = 0;
+    size_t dfaStates = 0;   //子集构造后
+    size_t minStates = 0;   //最小化后
+    size_t classes = 0;     //字符类数
+    size_t keywords = 0;    //由完美哈希识别、不占DFA状态的关键字数
+};
+
+/**
+ * @brief 生成结果，dfa.acceptTag为命中的规则下标（同长度匹配时靠前的规则优先）
+ * @note 关键字规则不进入DFA：词素落在keywordHost[k]规则的接受状态时，再查keywords确定是否为关键字k
+ */
+struct LexerTables {
+    DenseDFA<int16_t> dfa;
+    std::vector<std::u8string> ruleTypes;
+    KeywordTable keywords;
+    std::vector<int32_t> keywordHost;   //按规则下标，非关键字规则为-1
+};
+
+/**
+ * @brief 解析terminal.txt格式的文本，末尾追加内置的空白规则SKIP
+ */
+std::vector<LexRule> parseLexRules(std::string_view text);
+std::vector<LexRule> readLexRules(const std::filesystem::path & terminalPath);
+
+std::u8string escapeLiteral(std::u8string_view literal);
+
+/**
+ * @brief 由规则生成最小化、字符类压缩后的稠密DFA
+ * @param precomputed 编译期构造的关键字表，关键字集合与规则一致时直接采用，省去seed搜索
+ * @throws std::runtime_error 模式语法错误
+ */
+LexerTables generate(const std::vector<LexRule> & rules, LexerStats * stats = nullptr, const KeywordTable * precomputed = nullptr);
+
+} // namespace LexerGen
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef LCMP_PARSE_TABLE_HEADER
+#define LCMP_PARSE_TABLE_HEADER
+#include<cstdint>
+#include<vector>
+#include<span>
+#include<memory>
+#include<optional>
+#include<unordered_map>
+#include"SyntaxType.h"
+
+/**
+ * @brief 行位移压缩（comb）的LR分析表，ACTION与GOTO共用一张表
+ * @note 表项为int32：0为出错，正数v为移进/转移到状态v-1，负数v为按产生式-v-1归约；
+ *       状态s上符号x的表项位于base[s]+x，check同位置等于s时有效，查表只需几次数组访问；
+ *       数组以span持有，可指向自有存储或映射的分析表文件
+ */
+class ParseTable {
+public:
+    ParseTable() = default;
+    /**
+     * @brief 由ASTbaseContent中的哈希表形式的ACTION/GOTO表构造
+     * @note GOTO表只取非终结符列，终结符以ACTION表为准；按START的产生式归约即接受
+     */
+    static ParseTable build(
+        const std::vector<std::unordered_map<SymbolId, action>> & actionTable,
+        const std::vector<std::unordered_map<SymbolId, StateId>> & gotoTable,
+        const SymbolTable & symtab,
+        const std::unordered_map<ProductionId, Production> & Productions);
+
+    /**
+     * @brief 直接引用外部数组，owner负责其存活
+     * @attention 不检查数组内容，调用方须保证base[s]+symbolCount不超过value/check长度
+     */
+    struct Arrays {
+        std::span<const int32_t> base, check, value, lhs, arity;
+    };
+    static ParseTable view(Arrays arrays, int32_t startSymbol, size_t symbolCount, size_t entryCount, std::shared_ptr<const void> owner);
+
+    struct OptimizeStats {
+        size_t defaultStates = 0;   //只有一个归约动作、不再查向前看的状态
+        size_t bypassedGotos = 0;   //跳过单产生式归约、直接转移到最终状态的GOTO表项
+    };
+    /**
+     * @brief 分析表后处理：默认归约与单产生式旁路，返回自有存储的新表
+     * @param forwarding 构造AST时直接返回唯一子结点的单产生式 A -> B
+     * @note 默认归约不看向前看符号，出错时比原表多做几次归约，但仍在移进出错的token之前发现；
+     *       t = GOTO(s,B)只有按forwarding中 A -> B 的默认归约时，GOTO(s,B)改为GOTO(s,A)，沿单产生式链传递。
+     *       旁路后不再为 A -> B 建结点，只适用于构造具体AST的驱动
+     */
+    ParseTable optimized(const SymbolTable & symtab, const std::vector<ProductionId> & forwarding, OptimizeStats * stats = nullptr) const;
+
+    static constexpr int32_t error = 0;
+    static constexpr bool isShift(int32_t entry) { return entry > 0; }
+    static constexpr bool isReduce(int32_t entry) { return entry < 0; }
+    static constexpr StateId shiftTarget(int32_t entry) { return StateId(entry - 1); }
+    static constexpr ProductionId reduceProd(int32_t entry) { return ProductionId(-entry - 1); }
+
+    inline int32_t entry(StateId state, SymbolId sym) const {
+        size_t i = static_cast<size_t>(base_[state]) + sym;
+        return check_[i] == static_cast<int32_t>(state) ? value_[i] : error;
+    }
+    /**
+     * @brief 状态的默认归约表项，未经optimized()处理或没有默认归约时为error
+     */
+    inline int32_t defaultReduce(StateId state) const {
+        return defaults_.empty() ? error : defaults_[state];
+    }
+    /**
+     * @brief 归约后按左部转移，表中没有该转移时为空（-g载入的JSON表不经校验）
+     */
+    inline std::optional<StateId> gotoState(StateId state, NonTerminalId lhs) const {
+        const int32_t e = entry(state, SymbolId(lhs));
+        if(!isShift(e)) return std::nullopt;
+        return shiftTarget(e);
+    }
+    inline NonTerminalId lhs(ProductionId prod) const { return NonTerminalId(lhs_[prod]); }
+    inline size_t arity(ProductionId prod) const { return static_cast<size_t>(arity_[prod]); }
+    inline bool isAccept(ProductionId prod) const { return lhs_[prod] == startSymbol_; }
+
+    inline size_t stateCount() const { return base_.size(); }
+    inline size_t symbolCount() const { return symbolCount_; }
+    /**
+     * @brief 压缩后value/check的长度，与stateCount()*symbolCount()的稠密表相比
+     */
+    inline size_t packedSize() const { return value_.size(); }
+    inline size_t entryCount() const { return entries_; }
+    inline size_t productionCount() const { return lhs_.size(); }
+    inline int32_t startSymbol() const { return startSymbol_; }
+    inline Arrays arrays() const { return Arrays{base_, check_, value_, lhs_, arity_}; }
+
+private:
+    std::span<const int32_t> base_;     //按状态
+    std::span<const int32_t> check_;
+    std::span<const int32_t> value_;
+    std::span<const int32_t> lhs_;      //按产生式
+    std::span<const int32_t> arity_;
+    std::span<const int32_t> defaults_; //按状态，可为空
+    std::shared_ptr<const void> owner_;
+    int32_t startSymbol_ = -1;
+    size_t symbolCount_ = 0;
+    size_t entries_ = 0;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef LCMP_PARSE_TABLE_FILE_HEADER
+#define LCMP_PARSE_TABLE_FILE_HEADER
+#include<cstdint>
+#include<memory>
+#include<span>
+#include<string_view>
+#include<optional>
+#include<filesystem>
+#include"parseTable.h"
+#include"parserGen.h"
+#include"sourceFile.h"
+
+namespace LCMPFileIO
+{
+
+/**
+ * @brief 二进制分析表文件(.lcpt)的文件头，其后各段按8字节对齐，整数均为小端
+ * @note 段依次为：符号记录、产生式左部/右部长度/右部起点/右部符号、压缩分析表base/check/value、
+ *       各状态项目起点/项目(产生式,点位置)、字符串池；格式变化时递增version
+ */
+struct ParseTableHeader {
+    char magic[4];              // "LCPT"
+    uint32_t version;
+    uint32_t byteOrder;         // 0x01020304，按本机字节序写入
+    uint32_t symbolCount;
+    uint32_t productionCount;
+    uint32_t stateCount;
+    uint32_t packedSize;
+    uint32_t entryCount;
+    int32_t startSymbol;
+    uint32_t rhsCount;
+    uint32_t itemCount;
+    uint32_t stringBytes;
+    uint64_t grammarHash;       //生成时的文法源文件指纹，见grammarHash()
+    uint64_t checksum;          //符号、产生式与字符串池各段的FNV-1a，打开时校验
+    uint64_t symbolsOffset;
+    uint64_t lhsOffset;
+    uint64_t arityOffset;
+    uint64_t rhsBeginOffset;
+    uint64_t rhsOffset;
+    uint64_t baseOffset;
+    uint64_t checkOffset;
+    uint64_t valueOffset;
+    uint64_t stateBeginOffset;
+    uint64_t itemsOffset;
+    uint64_t stringsOffset;
+};
+
+inline constexpr uint32_t parseTableVersion = 2;
+
+/**
+ * @brief 符号记录，三个字符串均为字符串池中的(偏移,长度)
+ */
+struct ParseTableSymbol {
+    uint32_t sym, symLength;
+    uint32_t type, typeLength;
+    uint32_t pattern, patternLength;
+    uint32_t terminal;
+    uint32_t reserved;
+};
+
+/**
+ * @brief 分析表各段的只读视图，来源为映射的.lcpt文件或编译进程序的常量数组
+ * @note items中每个项目占两项：产生式id、点位置
+ */
+struct ParseTableImage {
+    uint64_t grammarHash = 0;
+    int32_t startSymbol = -1;
+    uint32_t entryCount = 0;
+    std::span<const ParseTableSymbol> symbols;
+    std::span<const int32_t> lhs, arity;
+    std::span<const uint32_t> rhsBegin, rhs;
+    std::span<const int32_t> base, check, value;
+    std::span<const uint32_t> stateBegin, items;
+    std::u8string_view strings;
+};
+
+/**
+ * @brief 文法的指纹，取grammar、terminal与冲突解决文件的原文及LR模式；任一源文件修改后，旧分析表的指纹即不再相符
+ * @param conflict 未指定时按空文件计
+ * @throws std::runtime_error 无法打开文件
+ */
+uint64_t grammarHash(const std::filesystem::path & grammar, const std::filesystem::path & terminals,
+                     const std::optional<std::filesystem::path> & conflict, LRMode mode);
+
+/**
+ * @brief 写出二进制分析表，table须由content构造
+ * @param hash 生成content所用源文件的grammarHash
+ */
+void writeParseTable(const ASTbaseContent & content, const ParseTable & table, uint64_t hash, const std::filesystem::path & path);
+/**
+ * @brief 把同样的各段写成constexpr数组的C++头文件，供编译进程序
+ * @param ns 生成的命名空间名
+ */
+void writeParseTableHeader(const ASTbaseContent & content, const ParseTable & table, uint64_t hash, const std::filesystem::path & path, std::string_view ns);
+/**
+ * @brief 把LR自动机直接编码为C++头文件：每个状态一个case，移进/归约按终结符SymbolId写成switch
+ * @note 生成的parse<Driver>(d)只依赖Driver的lookahead/shift/reduce/accept/error，AST的构造与查表驱动共用；
+ *       状态编号与table相同，报错时可用同一张表列出期望的符号；归约后没有GOTO转移时以左部调用error并失败
+ */
+void writeDirectParserHeader(const ASTbaseContent & content, const ParseTable & table, uint64_t hash, const std::filesystem::path & path, std::string_view ns);
+
+/**
+ * @brief 分析表，压缩表直接引用映射内存或常量数组，不做反序列化
+ * @note 符号表与产生式体量很小，按需构造；状态项目只在报告语法错误时按状态解码
+ */
+class ParseTableFile {
+public:
+    /**
+     * @brief 映射文件，校验各段的校验和与边界，查表时不再检查
+     * @throws std::runtime_error 无法打开、版本或字节序不符、内容损坏
+     */
+    static std::shared_ptr<const ParseTableFile> open(const std::filesystem::path & path);
+    /**
+     * @brief 引用静态存储的各段，如生成头文件中的数组
+     * @note 各段由生成器在构建时写出，不做校验
+     */
+    static std::shared_ptr<const ParseTableFile> fromImage(const ParseTableImage & image);
+
+    /**
+     * @brief 引用映射内存的分析表，映射随之存活
+     */
+    ParseTable table() const;
+    SymbolTable symbols() const;
+    std::unordered_map<ProductionId, Production> productions() const;
+    std::vector<dotProdc> stateItems(StateId state) const;
+    inline uint64_t grammarHash() const { return image_.grammarHash; }
+    inline size_t stateCount() const { return image_.base.size(); }
+
+private:
+    ParseTableFile() = default;
+    /**
+     * @throws std::runtime_error 各段长度或内容不一致
+     */
+    void validate(const std::string & origin) const;
+
+    ParseTableImage image_;
+    std::shared_ptr<const SourceFile> file_;    //来自文件时持有映射
+};
+
+/**
+ * @brief 构建时由grammar目录生成、编译进程序的默认文法
+ */
+std::shared_ptr<const ParseTableFile> builtinParseTable();
+
+} // namespace LCMPFileIO
+
+#endif
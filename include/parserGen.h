@@ -3,6 +3,7 @@
 #include"SyntaxType.h"
 
 void parserGen_test_main();
+int parserGen_test_main_tables();
 
 typedef struct ASTbaseContent {
     std::vector<std::vector<dotProdc>> states;
@@ -12,7 +13,20 @@ typedef struct ASTbaseContent {
     std::unordered_map<ProductionId, Production> Productions;
 }ASTbaseContent;
 
-ASTbaseContent parserGen(std::filesystem::path grammarFile , std::filesystem::path terminalsFile ,std::optional<std::filesystem::path> SLRruleFile);
+/**
+ * @brief 分析表的构造方式，SLR(1)与LALR(1)共用同一组LR(0)状态
+ */
+enum class LRMode {
+    SLR1,   //FOLLOW集
+    LALR1,  //DeRemer-Pennello LA集
+    LR1,    //LR(1)项目集，同核心且弱相容的状态合并（Pager）
+};
+
+/**
+ * @param threadCount 构造LR(0)项目集的线程数，1为串行，0取硬件线程数；状态编号与分析表不随之变化
+ * @throws std::runtime_error 优先级声明有误（未知的声明或终结符）
+ */
+ASTbaseContent parserGen(std::filesystem::path grammarFile , std::filesystem::path terminalsFile ,std::optional<std::filesystem::path> SLRruleFile, LRMode mode = LRMode::SLR1, size_t threadCount = 1);
 std::u8string formatProduction(const Production& prod, size_t dot_pos, const SymbolTable& symtab);
 
 #endif
\ No newline at end of file
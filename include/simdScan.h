@@ -0,0 +1,42 @@
+#ifndef LCMP_SIMD_SCAN_HEADER
+#define LCMP_SIMD_SCAN_HEADER
+#include<string_view>
+#include<cstddef>
+
+/**
+ * 词法扫描用的字节串批量跳过，运行时按CPUID选择AVX2/SSE2实现，非x86平台退化为标量
+ */
+namespace SimdScan
+{
+
+enum class Level {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+/**
+ * @brief 本机支持的最高实现
+ */
+Level detectedLevel();
+/**
+ * @brief 当前使用的实现
+ */
+Level level();
+/**
+ * @brief 切换实现（基准测试用，勿与扫描并发调用），超过detectedLevel()时取detectedLevel()
+ */
+void setLevel(Level lv);
+const char * levelName(Level lv);
+
+/**
+ * @brief 从pos起跳过连续的某类字节
+ * @return 第一个不属于该类的下标，或input.size()
+ */
+size_t skipSpace(std::u8string_view input, size_t pos);   // [ \t\r\n]
+size_t skipDigit(std::u8string_view input, size_t pos);   // [0-9]
+size_t skipAlnum(std::u8string_view input, size_t pos);   // [a-zA-Z0-9]
+
+} // namespace SimdScan
+
+#endif
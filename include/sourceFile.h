@@ -0,0 +1,49 @@
+#ifndef LCMP_SOURCE_FILE_HEADER
+#define LCMP_SOURCE_FILE_HEADER
+#include<string>
+#include<string_view>
+#include<memory>
+#include<filesystem>
+
+namespace LCMPFileIO
+{
+
+/**
+ * @brief 只读源码缓冲区，词法器直接在其视图上扫描，不再拷贝
+ * @note 普通文件以只读mmap映射并提示顺序访问；管道、标准输入、空文件或映射失败时退化为一次读入
+ */
+class SourceFile {
+public:
+    /**
+     * @param path 为"-"时读标准输入
+     * @throws std::runtime_error 无法打开或读取
+     */
+    static std::shared_ptr<const SourceFile> open(const std::filesystem::path & path);
+    static std::shared_ptr<const SourceFile> fromStdin();
+    static std::shared_ptr<const SourceFile> fromString(std::u8string text);
+
+    ~SourceFile();
+    SourceFile(const SourceFile &) = delete;
+    SourceFile & operator=(const SourceFile &) = delete;
+
+    inline std::u8string_view view() const { return view_; }
+    inline size_t size() const { return view_.size(); }
+    /**
+     * @brief 内容是否来自文件映射
+     */
+    inline bool mapped() const { return mapping_ != nullptr; }
+
+private:
+    SourceFile() = default;
+    std::u8string owned_;           //未映射时的内容
+    std::u8string_view view_;
+    void * mapping_ = nullptr;
+    size_t mappedBytes_ = 0;
+#ifdef _WIN32
+    void * mappingHandle_ = nullptr;
+#endif
+};
+
+} // namespace LCMPFileIO
+
+#endif
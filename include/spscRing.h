@@ -0,0 +1,60 @@
+#ifndef LCMP_SPSC_RING_HEADER
+#define LCMP_SPSC_RING_HEADER
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+
+/**
+ * @brief 有界单生产者单消费者无锁环形缓冲
+ * @note 槽位预先分配，生产者在槽位上原地写入后提交，消费者原地读取后释放，不拷贝元素；
+ *       beginWrite/commitWrite只能由生产者线程调用，beginRead/commitRead只能由消费者线程调用
+ */
+template<typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) : slots_(capacity), mask_(capacity - 1) {
+        if(capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("SpscRing容量须为2的幂");
+        }
+    }
+    SpscRing(const SpscRing &) = delete;
+    SpscRing & operator=(const SpscRing &) = delete;
+
+    /**
+     * @brief 取下一个可写槽位，满时返回nullptr
+     */
+    T * beginWrite() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if(tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+            return nullptr;
+        }
+        return &slots_[tail & mask_];
+    }
+    void commitWrite() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1,std::memory_order_release);
+    }
+    /**
+     * @brief 取最早提交的槽位，空时返回nullptr
+     */
+    T * beginRead() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if(head == tail_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+    void commitRead() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1,std::memory_order_release);
+    }
+    size_t capacity() const { return slots_.size(); }
+
+private:
+    std::vector<T> slots_;
+    const size_t mask_;
+    //两端计数分处不同缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+#endif
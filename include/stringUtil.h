@@ -7,6 +7,8 @@
 #include <string>
 #include <stdexcept>
 #include <cstdint>
+#include <optional>
+#include <string_view>
 
 template<typename T>
 concept HasCStr = requires(T t) {
@@ -107,6 +109,13 @@ int string_test_main();
 
 size_t u8len(const std::u8string & str);
 
+/**
+ * @brief 单遍校验UTF-8编码（拒绝过长编码、代理区与超出U+10FFFF的码点），不抛异常
+ * @return 第一个非法序列起始字节的偏移，全部合法时为std::nullopt
+ * @note ASCII部分按16/64字节块批量跳过
+ */
+std::optional<size_t> validate_utf8(std::u8string_view str);
+
 std::u8string head_u8char(const std::u8string & str);
 
 std::u8string replace(const std::u8string& src, const std::u8string& pattern, const std::u8string& alt);
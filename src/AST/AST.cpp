@@ -2,36 +2,70 @@
 #include "AST/NodeType/ASTBool.h"
 #include "AST/NodeType/Stmt.h"
 #include "stringUtil.h"
+#include "defaultDirectParser.h"
 
 namespace AST
 {
 
 StateId startStateId(0);
 
-bool AbstractSyntaxTree::BuildCommonAST(const std::vector<Lexer::scannerToken_t> & tokens) {
+std::vector<std::optional<SymbolId>> buildTokenKindMap(const SymbolTable & symtab) {
+    std::vector<std::optional<SymbolId>> ret(Lexer::kindCount());
+    for(size_t kind = 0 ; kind < ret.size() ; kind++) {
+        auto Ids = symtab.find_index_type(Lexer::kindName(static_cast<Lexer::TokenKind>(kind)));
+        std::erase_if(Ids,[&symtab](SymbolId id) { return !symtab[id].is_terminal(); });
+        if(Ids.size() == 1) {
+            ret[kind] = Ids[0];
+        }
+        else if(Ids.size() > 1) {
+            std::cerr<<"文法内部冲突, token type:"<< toString(Lexer::kindName(static_cast<Lexer::TokenKind>(kind))) <<" 对应多个终结符\n";
+        }
+    }
+    return ret;
+}
+
+std::vector<dotProdc> AbstractSyntaxTree::stateItems(StateId state) const {
+    if(tableFile) {
+        return tableFile->stateItems(state);
+    }
+    return states[state];
+}
+
+ParseTable::OptimizeStats AbstractSyntaxTree::optimizeParseTable() {
+    std::vector<ProductionId> forwarding;
+    for(auto prodStr : pType::ForwardProd) {
+        U8StrProduction u8prod = LCMPFileIO::parseProduction(prodStr);
+        for(const auto & [pid,prod] : Productions) {
+            if(equals(u8prod,prod,symtab)) forwarding.push_back(pid);
+        }
+    }
+    ParseTable::OptimizeStats stats;
+    optimizedTable = parseTable.optimized(symtab,forwarding,&stats);
+    return stats;
+}
+
+bool AbstractSyntaxTree::BuildCommonAST(const Lexer::TokenList & tokens) {
     if(tokens.back().value != u8"$") {
         std::cerr<<"tokens末尾非结束符";
         return false;
     }
     root = nullptr;
-    std::stack<StateId> StateStack;
-    std::stack<unique_ptr<ASTNode>> symStack;
+    std::vector<StateId> StateStack;
+    std::vector<unique_ptr<ASTNode>> symStack;
     // auto curr_state = startStateId;
-    StateStack.push(startStateId);
+    StateStack.push_back(startStateId);
     for(int token_i = 0 ; token_i < tokens.size() ;){
-        auto token = tokens[token_i];
-        SymbolId tokenSymId;
+        const auto & token = tokens[token_i];
         //获取token对应symbolId
-        auto Ids = symtab.find_index_type(token.type);
-        if(Ids.size()!=1) {
+        if(token.kind >= tokenKindSymbol.size() || !tokenKindSymbol[token.kind]) {
             std::cerr<<"文法内部冲突, token type:"<< toString(token.type) <<" - symbolId解析错误";
             throw std::runtime_error("文法内部冲突, type 解析错误");
         }
-        tokenSymId = Ids[0];
+        SymbolId tokenSymId = tokenKindSymbol[token.kind].value();
         
-        action now_action;
-        if(! actionTable[StateStack.top()].count(tokenSymId)) {
-            for(auto p : states[StateStack.top()]) {
+        const int32_t now_action = parseTable.entry(StateStack.back(),tokenSymId);
+        if(now_action == ParseTable::error) {
+            for(auto p : stateItems(StateStack.back())) {
                 auto prod_it = Productions.find(p.producId);
                 if(prod_it == Productions.end()) {
                     std::cerr << "Invalid production ID in state";
@@ -42,11 +76,11 @@ bool AbstractSyntaxTree::BuildCommonAST(const std::vector<Lexer::scannerToken_t>
             }
             std::cout<<std::endl;
             
-            std::cerr << "unexpected token :" << toString(symtab[tokenSymId].sym()) << " atPos: " << token_i << "\n";
+            std::cerr << "unexpected token :" << toString(symtab[tokenSymId].sym()) << " atPos: " << token_i << " (" << tokens.line(token_i) << ":" << tokens.column(token_i) << ")\n";
             std::vector<std::u8string> expectedSym;
-            for(const auto & s : actionTable[StateStack.top()]) {
-                if(symtab[s.first].is_terminal()) {
-                    expectedSym.push_back(symtab[s.first].sym());
+            for(const auto & s : symtab.symbols()) {
+                if(s.is_terminal() && parseTable.entry(StateStack.back(),SymbolId(s.index())) != ParseTable::error) {
+                    expectedSym.push_back(s.sym());
                 }
             }
             std::cerr << " Expected token:[";
@@ -57,57 +91,41 @@ bool AbstractSyntaxTree::BuildCommonAST(const std::vector<Lexer::scannerToken_t>
             return false;
         }
     
-        now_action = actionTable[StateStack.top()].at(tokenSymId);
-    
-        auto action_Visitor = overload {
-            [](StateId v) -> bool {return true;},
-            [](ProductionId v) -> bool {return false;}
-        };
-        bool isShift = std::visit(action_Visitor,now_action);
-        if(isShift) {
+        if(ParseTable::isShift(now_action)) {
             //移进
-            StateStack.push( std::get<StateId>(now_action) );
+            StateStack.push_back(ParseTable::shiftTarget(now_action));
             //给token建结点
             ASTCommonNode nt;
             nt.type = token.type;
             nt.value = token.value;
-            symStack.emplace(std::make_unique<ASTCommonNode>(std::move(nt)));
+            symStack.emplace_back(std::make_unique<ASTCommonNode>(std::move(nt)));
             //移进
             token_i++;
         }
         else {
             //归约
-            if(! Productions.count(std::get<ProductionId>(now_action))) {
-                std::cerr << "unable to find Production with id :" <<std::get<ProductionId>(now_action);
-                return false;
-            }
-            auto prod = Productions.at(std::get<ProductionId>(now_action));
-            if(symtab[prod.lhs()].sym() == u8"START") {
-                root = std::move(symStack.top());
-                symStack.pop();
+            const ProductionId prodId = ParseTable::reduceProd(now_action);
+            if(parseTable.isAccept(prodId)) {
+                root = std::move(symStack.back());
+                symStack.pop_back();
                 return true;
             }
-            size_t popsize = prod.rhs().size();
+            const size_t popsize = parseTable.arity(prodId);
+            const NonTerminalId lhs = parseTable.lhs(prodId);
             ASTCommonNode nt;
-            nt.type = symtab[prod.lhs()].sym();
+            nt.type = symtab[lhs].sym();
             nt.value = u8"";
-            std::vector<unique_ptr<ASTNode>> ntchilds;
-            for(int i=0;i<popsize;i++) {
-                ntchilds.emplace_back(std::move(symStack.top()));
-                StateStack.pop();
-                symStack.pop();
-            }
-            for(int i = popsize-1;i>=0;i--) {
-                nt.childs.emplace_back(std::move(ntchilds[i]));
-            }
-            symStack.emplace(std::make_unique<ASTCommonNode>(std::move(nt)));
+            nt.childs.assign(std::make_move_iterator(symStack.end() - popsize),std::make_move_iterator(symStack.end()));
+            symStack.resize(symStack.size() - popsize);
+            StateStack.resize(StateStack.size() - popsize);
+            symStack.emplace_back(std::make_unique<ASTCommonNode>(std::move(nt)));
             //查表当前归约非终结符后的下一个状态
-            if(! gotoTable[StateStack.top()].count(SymbolId(prod.lhs()) )) {
+            auto next = parseTable.gotoState(StateStack.back(),lhs);
+            if(!next) {
                 std::cerr << "AST构建内部错误 , goto表找不到对应非终结符转移规则" ;
                 return false;
             }
-            auto nextState = gotoTable[StateStack.top()].at(SymbolId(prod.lhs()));
-            StateStack.push(nextState);
+            StateStack.push_back(next.value());
             //不移进
         }
     }
@@ -117,109 +135,190 @@ bool AbstractSyntaxTree::BuildCommonAST(const std::vector<Lexer::scannerToken_t>
     // return true;
 }
 
-bool AbstractSyntaxTree::BuildSpecifiedAST(const std::vector<Lexer::scannerToken_t> & tokens) {
-        if(tokens.back().value != u8"$") {
-        std::cerr<<"tokens末尾非结束符";
-        return false;
+namespace {
+
+/**
+ * @brief 把TokenList包装成与TokenStream相同的游标接口
+ */
+class TokenListCursor {
+public:
+    explicit TokenListCursor(const Lexer::TokenList & tokens_) : tokens(tokens_) {}
+    Lexer::scannerToken_t peek() const { return tokens[i]; }
+    void next() { if(i + 1 < tokens.size()) i++; }
+    size_t index() const { return i; }
+    size_t line() const { return tokens.line(i); }
+    size_t column() const { return tokens.column(i); }
+    std::optional<Lexer::TokenLiteral> literal() const { return tokens.literal(i); }
+private:
+    const Lexer::TokenList & tokens;
+    size_t i = 0;
+};
+
+/**
+ * @brief 查表驱动与直接编码驱动共用的移进/归约动作：为token建终结符结点，按产生式构造具体AST结点
+ * @note 接口即生成的DefaultDirectParser::parse所要求的Driver
+ */
+template<typename TokenCursor>
+class SpecifiedASTActions {
+public:
+    SpecifiedASTActions(AbstractSyntaxTree & tree_, TokenCursor & tokens_, const ParseTable & table_)
+        : tree(tree_), tokens(tokens_), table(table_)
+    {
+        tree.steps = AbstractSyntaxTree::ParseSteps{};
+        tree.root = nullptr;
     }
-    root = nullptr;
-    std::stack<StateId> StateStack;
-    std::stack<unique_ptr<ASTNode>> symStack;
-    // auto curr_state = startStateId;
-    StateStack.push(startStateId);
-    for(int token_i = 0 ; token_i < tokens.size() ;){
-        auto token = tokens[token_i];
-        SymbolId tokenSymId;
+    /**
+     * @return 当前token对应的终结符，词法错误时为-1
+     */
+    int32_t lookahead() {
+        token = tokens.peek();
+        if(token.kind == Lexer::kindERR) {
+            std::cerr<<"Lexer解析失败:无法解析的符号"<<toString(token.value)<<" 位于"<<tokens.line()<<"行"<<tokens.column()<<"列\n";
+            return -1;
+        }
         //获取token对应symbolId
-        auto Ids = symtab.find_index_type(token.type);
-        if(Ids.size()!=1) {
+        if(token.kind >= tree.tokenKindSymbol.size() || !tree.tokenKindSymbol[token.kind]) {
             std::cerr<<"文法内部冲突, token type:"<< toString(token.type) <<" - symbolId解析错误";
             throw std::runtime_error("文法内部冲突, type 解析错误");
         }
-        tokenSymId = Ids[0];
-        
-        action now_action;
-        if(! actionTable[StateStack.top()].count(tokenSymId)) {
-            for(auto p : states[StateStack.top()]) {
-                auto prod_it = Productions.find(p.producId);
-                if(prod_it == Productions.end()) {
-                    std::cerr << "Invalid production ID in state";
-                    continue;
-                }
-                const auto& prod = prod_it->second;
-                std::cout << toString(formatProduction(prod, p.dot_pos, symtab)) << " ";
-            }
-            std::cout<<std::endl;
-            
-            std::cerr << "unexpected token :" << toString(symtab[tokenSymId].sym()) << " atPos: " << token_i << "\n";
-            std::vector<std::u8string> expectedSym;
-            for(const auto & s : actionTable[StateStack.top()]) {
-                if(symtab[s.first].is_terminal()) {
-                    expectedSym.push_back(symtab[s.first].sym());
-                }
+        return static_cast<int32_t>(tree.tokenKindSymbol[token.kind].value());
+    }
+    void shift() {
+        tree.steps.shifts++;
+        //给token建结点
+        TermSymNode nt;
+        nt.token_type = token.type;
+        nt.value = token.value;
+        nt.literal = tokens.literal();
+        symStack.emplace_back(std::make_unique<TermSymNode>(std::move(nt)));
+        tokens.next();
+    }
+    bool reduce(uint32_t prod, size_t popsize) {
+        tree.steps.reduces++;
+        auto nt = std::make_unique<AST::NonTermProdNode>();
+        nt->prodId = ProductionId(prod);
+        nt->childs.assign(std::make_move_iterator(symStack.end() - popsize),std::make_move_iterator(symStack.end()));
+        symStack.resize(symStack.size() - popsize);
+        unique_ptr<ASTNode> specifiedNode = AST_specified_node_construct(std::move(nt),&tree);
+        if(!specifiedNode) {
+            throw std::runtime_error("");
+        }
+        symStack.emplace_back(std::move(specifiedNode));
+        return true;
+    }
+    void accept() {
+        tree.steps.reduces++;
+        tree.root = std::move(symStack.back());
+        symStack.pop_back();
+    }
+    void error(uint32_t state, int32_t sym) {
+        //归约后没有GOTO转移，说明分析表本身有误
+        if(!tree.symtab[SymbolId(sym)].is_terminal()) {
+            std::cerr << "AST构建内部错误 , goto表找不到对应非终结符转移规则" ;
+            return;
+        }
+        for(auto p : tree.stateItems(StateId(state))) {
+            auto prod_it = tree.Productions.find(p.producId);
+            if(prod_it == tree.Productions.end()) {
+                std::cerr << "Invalid production ID in state";
+                continue;
             }
-            std::cerr << " Expected token:[";
-            for(const auto & s : expectedSym ) {
-                std::cerr <<"\"" <<toString(s) <<"\" ";
+            const auto& prod = prod_it->second;
+            std::cout << toString(formatProduction(prod, p.dot_pos, tree.symtab)) << " ";
+        }
+        std::cout<<std::endl;
+        
+        std::cerr << "unexpected token :" << toString(tree.symtab[SymbolId(sym)].sym()) << " atPos: " << tokens.index() << " (" << tokens.line() << ":" << tokens.column() << ")\n";
+        std::vector<std::u8string> expectedSym;
+        for(const auto & s : tree.symtab.symbols()) {
+            if(s.is_terminal() && table.entry(StateId(state),SymbolId(s.index())) != ParseTable::error) {
+                expectedSym.push_back(s.sym());
             }
-            std::cerr <<"]"<<std::endl;
+        }
+        std::cerr << " Expected token:[";
+        for(const auto & s : expectedSym ) {
+            std::cerr <<"\"" <<toString(s) <<"\" ";
+        }
+        std::cerr <<"]"<<std::endl;
+    }
+private:
+    AbstractSyntaxTree & tree;
+    TokenCursor & tokens;
+    const ParseTable & table;
+    Lexer::scannerToken_t token;
+    std::vector<unique_ptr<ASTNode>> symStack;
+};
+
+} // namespace
+
+bool AbstractSyntaxTree::BuildSpecifiedAST(const Lexer::TokenList & tokens) {
+    if(tokens.back().value != u8"$") {
+        std::cerr<<"tokens末尾非结束符";
+        return false;
+    }
+    TokenListCursor cursor(tokens);
+    return BuildSpecifiedASTImpl(cursor);
+}
+
+bool AbstractSyntaxTree::BuildSpecifiedAST(Lexer::TokenStream & tokens) {
+    return BuildSpecifiedASTImpl(tokens);
+}
+
+bool AbstractSyntaxTree::BuildSpecifiedAST(Lexer::PipelinedTokenStream & tokens) {
+    return BuildSpecifiedASTImpl(tokens);
+}
+
+/**
+ * @brief LR驱动，TokenCursor提供peek/next/index/line/column/literal
+ */
+template<typename TokenCursor>
+bool AbstractSyntaxTree::BuildSpecifiedASTImpl(TokenCursor & tokens) {
+    const ParseTable & table = optimizedTable.stateCount() != 0 ? optimizedTable : parseTable;
+    SpecifiedASTActions<TokenCursor> actions(*this,tokens,table);
+    std::vector<StateId> StateStack;
+    // auto curr_state = startStateId;
+    StateStack.push_back(startStateId);
+    while(true) {
+        const int32_t tokenSym = actions.lookahead();
+        if(tokenSym < 0) {
+            return false;
+        }
+        const SymbolId tokenSymId = SymbolId(tokenSym);
+        
+        int32_t now_action = table.defaultReduce(StateStack.back());
+        if(now_action != ParseTable::error) {
+            steps.defaultReduces++;
+        }
+        else {
+            now_action = table.entry(StateStack.back(),tokenSymId);
+        }
+        if(now_action == ParseTable::error) {
+            actions.error(StateStack.back(),tokenSym);
             return false;
         }
     
-        now_action = actionTable[StateStack.top()].at(tokenSymId);
-    
-        auto action_Visitor = overload {
-            [](StateId v) -> bool {return true;},
-            [](ProductionId v) -> bool {return false;}
-        };
-        bool isShift = std::visit(action_Visitor,now_action);
-        if(isShift) {
+        if(ParseTable::isShift(now_action)) {
             //移进
-            StateStack.push( std::get<StateId>(now_action) );
-            //给token建结点
-            TermSymNode nt;
-            nt.token_type = token.type;
-            nt.value = token.value;
-            symStack.emplace(std::make_unique<TermSymNode>(std::move(nt)));
-            //移进
-            token_i++;
+            StateStack.push_back(ParseTable::shiftTarget(now_action));
+            actions.shift();
         }
         else {
             //归约
-            if(! Productions.count(std::get<ProductionId>(now_action))) {
-                std::cerr << "unable to find Production with id :" <<std::get<ProductionId>(now_action);
-                return false;
-            }
-            auto prod = Productions.at(std::get<ProductionId>(now_action));
-            if(symtab[prod.lhs()].sym() == u8"START") {
-                root = std::move(symStack.top());
-                symStack.pop();
+            const ProductionId prodId = ParseTable::reduceProd(now_action);
+            if(table.isAccept(prodId)) {
+                actions.accept();
                 return true;
             }
-            size_t popsize = prod.rhs().size();
-            auto nt = std::make_unique<AST::NonTermProdNode>();
-            nt->prodId = prod.index();
-            std::vector<unique_ptr<ASTNode>> ntchilds;
-            for(int i=0;i<popsize;i++) {
-                ntchilds.emplace_back(std::move(symStack.top()));
-                StateStack.pop();
-                symStack.pop();
-            }
-            for(int i = popsize-1;i>=0;i--) {
-                nt->childs.emplace_back(std::move(ntchilds[i]));
-            }
-            unique_ptr<ASTNode> specifiedNode = AST_specified_node_construct(std::move(nt),this);
-            if(!specifiedNode) {
-                throw std::runtime_error("");
-            }
-            symStack.emplace(std::move(specifiedNode));
+            const size_t popsize = table.arity(prodId);
+            actions.reduce(prodId,popsize);
+            StateStack.resize(StateStack.size() - popsize);
             //查表当前归约非终结符后的下一个状态
-            if(! gotoTable[StateStack.top()].count(SymbolId(prod.lhs()) )) {
+            auto next = table.gotoState(StateStack.back(),table.lhs(prodId));
+            if(!next) {
                 std::cerr << "AST构建内部错误 , goto表找不到对应非终结符转移规则" ;
                 return false;
             }
-            auto nextState = gotoTable[StateStack.top()].at(SymbolId(prod.lhs()));
-            StateStack.push(nextState);
+            StateStack.push_back(next.value());
             //不移进
         }
     }
@@ -230,6 +329,40 @@ bool AbstractSyntaxTree::BuildSpecifiedAST(const std::vector<Lexer::scannerToken
 
 }
 
+bool AbstractSyntaxTree::hasDirectParser() const {
+    //JSON分析表不带源文件指纹，无法确认与直接编码分析器同源
+    return tableFile && tableFile->grammarHash() == DefaultDirectParser::grammarHash;
+}
+
+bool AbstractSyntaxTree::BuildSpecifiedASTDirect(const Lexer::TokenList & tokens) {
+    if(tokens.back().value != u8"$") {
+        std::cerr<<"tokens末尾非结束符";
+        return false;
+    }
+    TokenListCursor cursor(tokens);
+    return BuildSpecifiedASTDirectImpl(cursor);
+}
+
+bool AbstractSyntaxTree::BuildSpecifiedASTDirect(Lexer::TokenStream & tokens) {
+    return BuildSpecifiedASTDirectImpl(tokens);
+}
+
+bool AbstractSyntaxTree::BuildSpecifiedASTDirect(Lexer::PipelinedTokenStream & tokens) {
+    return BuildSpecifiedASTDirectImpl(tokens);
+}
+
+/**
+ * @brief 直接编码的驱动，状态编号与内置分析表相同，报错时按parseTable列出期望的符号
+ */
+template<typename TokenCursor>
+bool AbstractSyntaxTree::BuildSpecifiedASTDirectImpl(TokenCursor & tokens) {
+    if(!hasDirectParser()) {
+        throw std::runtime_error("直接编码的分析器只支持内置默认文法及由同一组文法文件生成的.lcpt");
+    }
+    SpecifiedASTActions<TokenCursor> actions(*this,tokens,parseTable);
+    return DefaultDirectParser::parse(actions);
+}
+
 void printCommonAST(const unique_ptr<ASTNode>& node, int depth) {
     // Check if node is ASTCommonNode using dynamic_cast
     if (auto commonNode = dynamic_cast<ASTCommonNode*>(node.get())) {
@@ -32,12 +32,15 @@ unique_ptr<ASTNode> ConstExpr::try_constructS(ASTNode * as , AbstractSyntaxTree
         }
         unique_ptr <ConstExpr> newNode = std::make_unique<ConstExpr>();
         auto * TermNode = static_cast<TermSymNode *>(NonTnode->childs[0].get());
+        if(!TermNode->literal) {
+            throw std::out_of_range("数值字面量无法表示: " + toString(TermNode->value));
+        }
         if(TermNode->token_type == u8"NUM") {
-            newNode->value = std::stoi(toString(TermNode->value));
+            newNode->value = std::get<int>(TermNode->literal.value());
             newNode->Type.basicType = baseType::INT;
         }
         else if(TermNode->token_type == u8"FLO") {
-            newNode->value = std::stof(toString(TermNode->value));
+            newNode->value = std::get<float>(TermNode->literal.value());
             newNode->Type.basicType = baseType::FLOAT;
         }
         else {
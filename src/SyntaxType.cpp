@@ -22,7 +22,7 @@ std::optional<SymbolId> SymbolTable::find_index(const std::u8string& sym) const
     return it != name_to_index_.end() ? std::optional(SymbolId(it->second)) : std::nullopt;
 }
 
-std::vector<SymbolId> SymbolTable::find_index_type(const std::u8string& type) const {
+std::vector<SymbolId> SymbolTable::find_index_type(std::u8string_view type) const {
     std::vector<SymbolId> ret;
     for(const auto & sym : this->symbols_) {
         if(sym.tokentype() == type)
@@ -0,0 +1,26 @@
+#include"parseTableFile.h"
+#include"defaultParseTable.h"
+
+std::shared_ptr<const LCMPFileIO::ParseTableFile> LCMPFileIO::builtinParseTable() {
+    //各段为构建时生成的静态常量数组，不再校验
+    static const std::shared_ptr<const ParseTableFile> instance = [] {
+        namespace T = DefaultParseTable;
+        ParseTableImage image;
+        image.grammarHash = T::grammarHash;
+        image.startSymbol = T::startSymbol;
+        image.entryCount = T::entryCount;
+        image.symbols = T::symbols;
+        image.lhs = T::lhs;
+        image.arity = T::arity;
+        image.rhsBegin = T::rhsBegin;
+        image.rhs = T::rhs;
+        image.base = T::base;
+        image.check = T::check;
+        image.value = T::value;
+        image.stateBegin = T::stateBegin;
+        image.items = T::items;
+        image.strings = T::strings;
+        return ParseTableFile::fromImage(image);
+    }();
+    return instance;
+}
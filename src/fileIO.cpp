@@ -6,45 +6,47 @@
 #include <filesystem>
 #include <set>
 
-void readTerminals(SymbolTable& symtable, std::filesystem::path terminalPath) {
-    std::ifstream file(terminalPath);
-    if (!file.is_open()) {
-        throw  std::runtime_error("Failed to open terminal file");
+std::vector<std::string> LCMPFileIO::splitTerminalLine(std::string line) {
+    std::vector<std::string> tokens;
+    // Skip empty lines and comments
+    if (line.empty() || line.find("//") == 0) {
+        return tokens;
     }
 
-    std::string line;
-    while (std::getline(file, line)) {
-        // Skip empty lines and comments
-        if (line.empty() || line.find("//") == 0) {
-            continue;
-        }
-
-        // Remove trailing comments
-        size_t commentPos = line.find("//");
-        if (commentPos != std::string::npos) {
-            line = line.substr(0, commentPos);
-        }
+    // Remove trailing comments
+    size_t commentPos = line.find("//");
+    if (commentPos != std::string::npos) {
+        line = line.substr(0, commentPos);
+    }
 
-        // Trim whitespace
-        line.erase(line.find_last_not_of(" \t") + 1);
-        line.erase(0, line.find_first_not_of(" \t"));
+    // Trim whitespace
+    line.erase(line.find_last_not_of(" \t\r") + 1);
+    line.erase(0, line.find_first_not_of(" \t"));
 
-        if (line.empty()) continue;
+    // Parse the line in format: "type","name","pattern" (or "type","name")
+    size_t start = 0;
+    while (true) {
+        size_t quote1 = line.find('"', start);
+        if (quote1 == std::string::npos) break;
 
-        // Parse the line in format: "type","name","pattern" (or "type","name")
-        std::vector<std::string> tokens;
-        size_t start = 0;
-        while (true) {
-            size_t quote1 = line.find('"', start);
-            if (quote1 == std::string::npos) break;
+        size_t quote2 = line.find('"', quote1 + 1);
+        if (quote2 == std::string::npos) break;
 
-            size_t quote2 = line.find('"', quote1 + 1);
-            if (quote2 == std::string::npos) break;
+        tokens.push_back(line.substr(quote1 + 1, quote2 - quote1 - 1));
+        start = quote2 + 1;
+    }
+    return tokens;
+}
 
-            tokens.push_back(line.substr(quote1 + 1, quote2 - quote1 - 1));
-            start = quote2 + 1;
-        }
+void readTerminals(SymbolTable& symtable, std::filesystem::path terminalPath) {
+    std::ifstream file(terminalPath);
+    if (!file.is_open()) {
+        throw  std::runtime_error("Failed to open terminal file");
+    }
 
+    std::string line;
+    while (std::getline(file, line)) {
+        auto tokens = LCMPFileIO::splitTerminalLine(line);
         if (tokens.size() < 2) continue; // At least "type","name" required
 
         std::string type = tokens[0];
@@ -195,6 +197,49 @@ void readProductionRule(SymbolTable& symtable, std::vector<Production>& producti
     }
 }
 
+PrecedenceTable readPrecedence(const SymbolTable& symtable, std::filesystem::path rulePath) {
+    std::ifstream file(rulePath);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open rule file");
+    }
+
+    PrecedenceTable ret;
+    int level = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        // Remove trailing comments
+        size_t commentPos = line.find("//");
+        if (commentPos != std::string::npos) {
+            line = line.substr(0, commentPos);
+        }
+
+        std::istringstream iss(line);
+        std::string directive;
+        if (!(iss >> directive) || directive.front() != '%') continue;
+
+        Assoc assoc;
+        if (directive == "%left") assoc = Assoc::Left;
+        else if (directive == "%right") assoc = Assoc::Right;
+        else if (directive == "%nonassoc") assoc = Assoc::NonAssoc;
+        else throw std::runtime_error("未知的文法声明: " + directive);
+
+        //每行一个优先级，后声明的更高
+        level++;
+        std::string symbol;
+        while (iss >> symbol) {
+            if (symbol == "\\|") {
+                symbol = "|";
+            }
+            auto id = symtable.find_index(toU8str(symbol));
+            if (!id || !symtable[id.value()].is_terminal()) {
+                throw std::runtime_error("优先级声明中的未知终结符: " + symbol);
+            }
+            ret[id.value()] = Precedence{level, assoc};
+        }
+    }
+    return ret;
+}
+
 
 namespace LCMPFileIO {
     
@@ -4,412 +4,648 @@
 #include<string>
 #include<algorithm>
 #include<vector>
-#include<functional>
+#include<chrono>
+#include<charconv>
+#include<cstring>
+#include<limits>
+#include<stdexcept>
+#include<thread>
+#include<random>
 #include"stringUtil.h"
 #include"lexer.h"
+#include"lexerGen.h"
+#include"defaultTerminals.h"
+#include"simdScan.h"
 
 namespace Lexer
 {
 
-bool LexerInit = false;
-
-using token = std::pair<std::string,std::string>;
-const std::vector<token> wordkey = 
-    {{"INT","int"},
-    {"FLOAT","float"},
-    {"VOID","void"},
-    {"IF","if"},
-    {"ELSE","else"},
-    {"WHILE","while"},
-    {"RETURN","return"},
-    {"PRINT","print"} };
-const std::vector<token> skey = 
-    {{"LBR","{"},
-    {"LBK","["},
-    {"RBK","]"},
-    {"RBR","}"},
-    {"LPA","("},
-    {"RPA",")"},
-    {"SCO",";"},
-    {"CMA",","},
-    {"ADD","+"},
-    {"MUL","*"},
-    {"DIV","/"},
-    {"AND","&&"},
-    {"DEREF","&"},
-    {"OR","||"},
-    {"ROP","<"},
-    {"ROP","<="},
-    {"ROP",">"},
-    {"ROP","=="},
-    {"ASG","="},
-    {"SKIP"," "},
-    {"SKIP","\n"},
-    {"SKIP","\r"},
-    {"SKIP","\t"} };
-
-
-using state = int;
-#define mSTART 0
-#define mID 1
-#define mNUM 2
-#define mFLO 3
-
-typedef struct node_t
-{
-    bool acce;
-    std::string type;
-}node_t;
+namespace {
 
-node_t nodes[100];
-int move[120][256];
-int avai_node = 4;
+//内置terminal.txt的关键字表在编译期构造
+constexpr LexerGen::KeywordTable defaultKeywords = LexerGen::keywordsFromTerminals(defaultTerminalsText);
+static_assert(defaultKeywords.slotCount() != 0,"内置关键字无法构造完美哈希");
 
+} // namespace
 
-void insert_word_key(const std::vector<token> keys)
+Scanner::Scanner(const std::vector<LexerGen::LexRule> & rules)
 {
-    for(auto & key : keys)
-    {
-        state curr_state = mSTART;
-        for(auto & ch : key.second)
-        {
-            if(move[curr_state][ch] == -1 || move[curr_state][ch] == mID)
-            {
-                //分配一个新节点
-                move[curr_state][ch] = avai_node;
-                curr_state = avai_node;
-                nodes[curr_state].acce = true;
-                nodes[curr_state].type = "ID";
-                avai_node++;
-                for(int i = 'a',j='A' ; i<='z' ; )
-                {
-                    move[curr_state][i] = mID;
-                    move[curr_state][j] = mID;
-                    i++; j++;
-                }
-                for(int i = '0';i<='9';i++)
-                {
-                    move[curr_state][i] = mID;
-                }
-            }
-            else
-            {
-                curr_state = move[curr_state][ch];
-            }
-            if(&ch == &(key.second.back()))
-            {
-                if(! nodes[curr_state].acce || nodes[curr_state].type == "ID")
-                {
-                    //后插入的不覆盖
-                    nodes[curr_state].acce = true;
-                    nodes[curr_state].type = key.first;
-                }
-            }
+    //关键字集合与编译期表不一致（非内置规则）时，generate自行构造
+    tables_ = LexerGen::generate(rules,nullptr,&defaultKeywords);
+    auto names = std::make_shared<std::vector<std::u8string>>(std::vector<std::u8string>{u8"END",u8"ERR",u8"SKIP",u8"EOF"});
+    auto internKind = [&names](std::u8string_view type) {
+        auto it = std::find(names->begin(),names->end(),type);
+        if(it != names->end()) {
+            return static_cast<TokenKind>(it - names->begin());
         }
+        names->emplace_back(type);
+        return static_cast<TokenKind>(names->size() - 1);
+    };
+    for(const auto & type : tables_.ruleTypes) {
+        ruleKind_.push_back(internKind(type));
     }
-}
+    auto findKind = [&names](std::u8string_view type) {
+        auto it = std::find(names->begin(),names->end(),type);
+        return it == names->end() ? noKind : static_cast<TokenKind>(it - names->begin());
+    };
+    numKind_ = findKind(u8"NUM");
+    floKind_ = findKind(u8"FLO");
+    kindNames_ = std::move(names);
 
-void insert_noWord_key(const std::vector<token> keys)
-{
-    //插入非word类节点
-    for(auto & key : keys)
+    const auto & dfa = tables_.dfa;
+    stateKind_.assign(dfa.stateCount(),noKind);
+    for(size_t i = 0 ; i < dfa.stateCount() ; i++)
     {
-        state curr_state = mSTART;
-        for(auto & ch : key.second)
-        {
-            if(move[curr_state][ch] == -1)
-            {
-                //分配一个新节点
-                move[curr_state][ch] = avai_node;
-                curr_state = avai_node;
-                nodes[curr_state].acce = false;
-                nodes[curr_state].type = "";
-                avai_node++;
-            }
-            else
-            {
-                curr_state = move[curr_state][ch];
-            }
-            if(&ch == &(key.second.back()))
-            {
-                if(! nodes[curr_state].acce)
-                {
-                    //后插入的不覆盖
-                    nodes[curr_state].acce = true;
-                    nodes[curr_state].type = key.first;
-                }
-            }
+        if(dfa.acceptTag[i] >= 0) stateKind_[i] = ruleKind_[dfa.acceptTag[i]];
+    }
+    stateKeyword_.assign(dfa.stateCount(),0);
+    for(size_t i = 0 ; i < dfa.stateCount() ; i++)
+    {
+        auto & hosts = tables_.keywordHost;
+        stateKeyword_[i] = dfa.acceptTag[i] >= 0 && std::find(hosts.begin(),hosts.end(),dfa.acceptTag[i]) != hosts.end();
+    }
+    auto loopsOn = [&dfa](int16_t st, auto pred) {
+        for(int ch = 0 ; ch < 256 ; ch++) {
+            if(pred(ch) && dfa.next(st,static_cast<uint8_t>(ch)) != st) return false;
+        }
+        return true;
+    };
+    auto isDigit = [](int ch) { return '0' <= ch && ch <= '9'; };
+    auto isAlnum = [](int ch) { return ('0' <= ch && ch <= '9') || ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z'); };
+    stateLoop_.assign(dfa.stateCount(),SelfLoop::None);
+    for(size_t i = 0 ; i < dfa.stateCount() ; i++)
+    {
+        int16_t st = static_cast<int16_t>(i);
+        if(loopsOn(st,isAlnum)) stateLoop_[i] = SelfLoop::Alnum;
+        else if(loopsOn(st,isDigit)) stateLoop_[i] = SelfLoop::Digit;
+    }
+    //起始状态读入任一空白字节后即为无出边的SKIP状态时，空白串可整段跳过
+    skipSpaceRun_ = true;
+    for(uint8_t ch : {' ','\t','\r','\n'})
+    {
+        int16_t st = dfa.next(dfa.initial,ch);
+        if(st == dfa.dead || stateKind_[st] != kindSKIP) {
+            skipSpaceRun_ = false;
+            break;
+        }
+        for(size_t cls = 0 ; cls < dfa.classCount ; cls++) {
+            if(dfa.nextByClass(st,cls) != dfa.dead) skipSpaceRun_ = false;
         }
     }
+    for(int ch = 0 ; ch < 256 ; ch++)
+    {
+        bool sync = true;
+        for(size_t i = 0 ; sync && i < dfa.stateCount() ; i++) {
+            int16_t st = static_cast<int16_t>(i);
+            if(st != dfa.initial && dfa.next(st,static_cast<uint8_t>(ch)) != dfa.dead) sync = false;
+        }
+        syncByte_[ch] = sync;
+    }
+}
+
+const Scanner & Scanner::defaultScanner() {
+    //规则来自构建时嵌入的grammar/terminal.txt；局部静态变量的初始化由语言保证只发生一次
+    static const Scanner instance(LexerGen::parseLexRules(defaultTerminalsText));
+    return instance;
 }
 
-void insert_id()
+/**
+ * @brief 从start_index起按最长匹配扫描一个token，循环实现，不分配内存
+ * @return token类型与下一个token起点，token文本即input[start_index,next_start)
+ * @attention 非ASCII字节由ID模式[\x80-\xff]覆盖，UTF-8多字节字符整体落在同一个ID内
+ */
+Scanner::Step Scanner::matchToken(std::u8string_view input , size_t start_index) const
 {
-    nodes[mID].acce = true;
-    nodes[mID].type = "ID";
-    for(int i = 'a';i<='z';i++) {
-        if(move[mSTART][i]== -1) move[mSTART][i] = mID;
+    Step ret;
+    if(start_index == input.size())
+    {
+        ret.kind = kindEOF;
+        ret.next_start = start_index;
+        return ret;
     }
-    for(int i = 'A';i<='Z';i++) {
-        if(move[mSTART][i]== -1) move[mSTART][i] = mID;
+    const auto & dfa = tables_.dfa;
+    size_t accept_end = start_index; //上一个合法前缀的末尾index（不含）
+    int16_t accept_state = dfa.dead;
+    size_t curr_index = start_index;
+    int16_t curr_state = dfa.initial;
+    while(curr_index < input.size())
+    {
+        curr_state = dfa.next(curr_state,input[curr_index]);
+        if(curr_state == dfa.dead) {
+            break;
+        }
+        curr_index++;
+        //自环上的字节不改变状态，直接越过
+        if(stateLoop_[curr_state] == SelfLoop::Alnum) {
+            curr_index = SimdScan::skipAlnum(input,curr_index);
+        } else if(stateLoop_[curr_state] == SelfLoop::Digit) {
+            curr_index = SimdScan::skipDigit(input,curr_index);
+        }
+        if(stateKind_[curr_state] != noKind)
+        {
+            ret.kind = stateKind_[curr_state];
+            accept_end = curr_index;
+            accept_state = curr_state;
+        }
     }
-    for(int i = 'a',j='A' ; i<='z' ; )
+    ret.next_start = accept_end;
+    if(accept_state != dfa.dead && stateKeyword_[accept_state])
     {
-        move[mID][i] = mID;
-        move[mID][j] = mID;
-        i++; j++;
+        //关键字不占DFA状态，按最长匹配得到的词素查完美哈希
+        int rule = tables_.keywords.lookup(input.substr(start_index,accept_end - start_index));
+        if(rule != -1 && tables_.keywordHost[rule] == dfa.acceptTag[accept_state]) {
+            ret.kind = ruleKind_[rule];
+        }
     }
-    for(int i = '0';i<='9';i++)
+    if(accept_end == start_index)
     {
-        move[mID][i] = mID;
+        //没有成功推进
+        ret.kind = kindERR;
+        ret.next_start = start_index+1;
     }
-    
+    return ret;
+
 }
 
-void insert_num()
-{
-    for(int i = '0';i<='9';i++)
-    {
-        move[mSTART][i] = mNUM;
+/**
+ * @brief NUM/FLO文本转数值，失败（如越界）时返回nullopt
+ */
+std::optional<TokenLiteral> Scanner::parseLiteral(TokenKind kind, std::u8string_view text) const {
+    const char * first = reinterpret_cast<const char *>(text.data());
+    const char * last = first + text.size();
+    if(first != last && *first == '+') first++; //from_chars不接受正号
+    if(kind == numKind_) {
+        int v;
+        auto [ptr,ec] = std::from_chars(first,last,v);
+        if(ec == std::errc() && ptr == last) return v;
     }
-    state add = move[mSTART]['+'];
-    for(int i = '0';i<='9';i++)
-    {
-        move[add][i] = mNUM;
+    else if(kind == floKind_) {
+        float v;
+        auto [ptr,ec] = std::from_chars(first,last,v);
+        if(ec == std::errc() && ptr == last) return v;
     }
-    state negN = move[mSTART]['-'] = avai_node;
-    nodes[avai_node].acce = false;
-    nodes[avai_node].type = "";
-    avai_node++;
-    for(int i = '0';i<='9';i++)
+    return std::nullopt;
+}
+
+SourcePtr Scanner::adoptSource(SourcePtr && source) const {
+    //校验后DFA按字节扫描即可，非ASCII字节不再单独识别首字节
+    if(auto bad = validate_utf8(source->view()))
     {
-        move[negN][i] = mNUM;
-        move[mNUM][i] = mNUM;
+        std::cerr << "Invalid UTF-8 at byte offset " << bad.value() << '\n';
+    }
+    if(source->size() >= std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("源码过大，token偏移超出32位");
     }
-    nodes[mNUM].acce = true;
-    nodes[mNUM].type = "NUM";
+    return std::move(source);
 }
 
-void insert_flo()
-{
-    state curr = avai_node;
-    avai_node++;
-    nodes[curr].acce = false;
-    nodes[curr].type = "FLO TMP . NO ACCEPT";
-    move[mSTART]['.'] = curr;
-    move[move[mSTART]['-']]['.'] = curr;
-    move[move[mSTART]['+']]['.'] = curr;
+TokenList Scanner::beginList(SourcePtr && source) const {
+    TokenList ret;
+    ret.kindNames_ = kindNames_;
+    ret.source_ = adoptSource(std::move(source));
+    return ret;
+}
 
-    nodes[mFLO].acce = true;
-    nodes[mFLO].type = "FLO";
-    move[mNUM]['.'] = mFLO;
+void Scanner::scanRange(std::u8string_view input, size_t start, TokenList & out) const {
+    out.kinds_.reserve(out.kinds_.size() + (input.size() - start) / 8 + 1);
+    out.begins_.reserve(out.begins_.size() + (input.size() - start) / 8 + 1);
+    out.lengths_.reserve(out.lengths_.size() + (input.size() - start) / 8 + 1);
+    size_t st = start;
+    while(1)
+    {
+        if(skipSpaceRun_) st = SimdScan::skipSpace(input,st);
+        auto lexret= matchToken(input,st);
+        if(lexret.kind == kindEOF) break;
+        if(lexret.kind != kindSKIP) {
+            emitToken(out,lexret.kind,st,input.substr(st,lexret.next_start - st));
+        }
+        st = lexret.next_start;
+    }
+}
 
-    for(int i = '0' ; i<= '9';i++) {
-        move[mFLO][i] = mFLO;
-        move[curr][i] = mFLO;
+void Scanner::emitToken(TokenList & out, TokenKind kind, size_t begin, std::u8string_view text) const {
+    if(kind == numKind_ || kind == floKind_) {
+        if(auto lit = parseLiteral(kind,text)) {
+            out.literalTokens_.push_back(static_cast<uint32_t>(out.kinds_.size()));
+            out.literals_.push_back(lit.value());
+        }
     }
-    
+    out.kinds_.push_back(kind);
+    out.begins_.push_back(static_cast<uint32_t>(begin));
+    out.lengths_.push_back(static_cast<uint32_t>(text.size()));
 }
 
-typedef struct mScanner_ret
-{
-    std::string type;
-    std::string value;
-    size_t next_start;
-}mScanner_ret;
+void Scanner::finishList(TokenList & out) const {
+    const std::u8string_view input(out.source_->view());
+    out.kinds_.push_back(kindEND);
+    out.begins_.push_back(static_cast<uint32_t>(input.size()));
+    out.lengths_.push_back(0);
+
+    out.lineStarts_.push_back(0);
+    const char8_t * data = input.data();
+    for(size_t pos = 0 ; pos < input.size() ; ) {
+        auto nl = static_cast<const char8_t *>(std::memchr(data + pos,'\n',input.size() - pos));
+        if(!nl) break;
+        pos = nl - data + 1;
+        out.lineStarts_.push_back(static_cast<uint32_t>(pos));
+    }
+}
 
-mScanner_ret scannerAgent(const std::string & input , size_t start_index)
-{
-    mScanner_ret ret;
-    if(start_index == input.size())
-    {
-        ret.type = "EOF";
-        ret.value = "EOF";
-        return ret;
+TokenList Scanner::scan(std::u8string u8input) const {
+    return scan(LCMPFileIO::SourceFile::fromString(std::move(u8input)));
+}
+
+TokenList Scanner::scan(SourcePtr source) const {
+    TokenList ret = beginList(std::move(source));
+    scanRange(ret.source_->view(),0,ret);
+    finishList(ret);
+    return ret;
+}
+
+RelexResult Scanner::relex(TokenList & tokens, const TextEdit & edit) const {
+    if(!tokens.source_ || tokens.kindNames_ != kindNames_) {
+        throw std::invalid_argument("relex: token列表不是由该扫描器产生");
     }
-    int lastloc = start_index-1; //上一个合法的字符末尾index（含）
-    size_t curr_index = start_index;
-    state curr_state = mSTART;
-    std::function<void(void)> scanner = [&input,&start_index,&lastloc,&ret,&curr_index,&curr_state,&scanner] {
-        char ch = input[curr_index];
-        //std::cout<<ch;
-        if(move[curr_state][ch] == -1) {
-            return;
+    const std::u8string_view old(tokens.source_->view());
+    if(edit.offset > old.size() || edit.removed > old.size() - edit.offset) {
+        throw std::invalid_argument("relex: 编辑范围越界");
+    }
+    const size_t oldEditEnd = edit.offset + edit.removed;
+    const size_t newEditEnd = edit.offset + edit.inserted.size();
+    const ptrdiff_t delta = static_cast<ptrdiff_t>(edit.inserted.size()) - static_cast<ptrdiff_t>(edit.removed);
+    if(old.size() + edit.inserted.size() - edit.removed >= std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("源码过大，token偏移超出32位");
+    }
+    if(auto bad = validate_utf8(edit.inserted)) {
+        std::cerr << "Invalid UTF-8 at byte offset " << edit.offset + bad.value() << '\n';
+    }
+
+    //token与AST以视图引用连续的源码，编辑后的源码整段拷贝，这一步及下面的平移均为O(n)
+    std::u8string text;
+    text.reserve(old.size() + edit.inserted.size() - edit.removed);
+    text.append(old.substr(0,edit.offset));
+    text.append(edit.inserted);
+    text.append(old.substr(oldEditEnd));
+    auto source = LCMPFileIO::SourceFile::fromString(std::move(text));
+    const std::u8string_view input(source->view());
+
+    //同步字节处必有token边界，且此前的token（含其向后试探）不会越过它，故从编辑点前最近的同步字节重扫
+    size_t restart = edit.offset;
+    while(restart > 0 && !syncByte_[old[restart - 1]]) restart--;
+    if(restart > 0) restart--;
+    const size_t firstOld = std::lower_bound(tokens.begins_.begin(),tokens.begins_.end(),restart) - tokens.begins_.begin();
+
+    //扫描器在token之间无状态：新token起点位于编辑之后、且对应旧列表中某token起点时，其后结果与旧列表相同
+    TokenList fresh;
+    size_t oldIdx = firstOld;
+    size_t st = restart;
+    while(true)
+    {
+        if(skipSpaceRun_) st = SimdScan::skipSpace(input,st);
+        if(st >= newEditEnd) {
+            size_t oldPos = st - newEditEnd + oldEditEnd;
+            while(tokens.begins_[oldIdx] < oldPos) oldIdx++;    //END的起点为旧源码末尾，循环必然停止
+            if(tokens.begins_[oldIdx] == oldPos) break;
         }
-        //移动
-        curr_state = move[curr_state][ch];
-        if(nodes[curr_state].acce)
-        {
-            ret.type = nodes[curr_state].type;
-            ret.value = ret.value + input.substr(lastloc+1,curr_index - lastloc); //拼接字符串
-            lastloc = curr_index;
+        auto lexret = matchToken(input,st);
+        if(lexret.kind != kindSKIP) {
+            emitToken(fresh,lexret.kind,st,input.substr(st,lexret.next_start - st));
         }
-        curr_index++;
-        scanner();
-        return;
+        st = lexret.next_start;
+    }
+    const size_t lastOld = oldIdx;
+
+    auto splice = [](auto & vec, size_t first, size_t last, const auto & src) {
+        vec.erase(vec.begin() + first,vec.begin() + last);
+        vec.insert(vec.begin() + first,src.begin(),src.end());
     };
-    scanner();
-    ret.next_start = lastloc+1;
-    if(lastloc < start_index)
-    {
-        ret.type="ERR";
-        ret.next_start = start_index+1;
+    splice(tokens.kinds_,firstOld,lastOld,fresh.kinds_);
+    splice(tokens.begins_,firstOld,lastOld,fresh.begins_);
+    splice(tokens.lengths_,firstOld,lastOld,fresh.lengths_);
+    for(size_t i = firstOld + fresh.kinds_.size() ; i < tokens.begins_.size() ; i++) {
+        tokens.begins_[i] = static_cast<uint32_t>(tokens.begins_[i] + delta);
+    }
+
+    const ptrdiff_t indexDelta = static_cast<ptrdiff_t>(fresh.kinds_.size()) - static_cast<ptrdiff_t>(lastOld - firstOld);
+    auto & litIdx = tokens.literalTokens_;
+    size_t litFirst = std::lower_bound(litIdx.begin(),litIdx.end(),static_cast<uint32_t>(firstOld)) - litIdx.begin();
+    size_t litLast = std::lower_bound(litIdx.begin(),litIdx.end(),static_cast<uint32_t>(lastOld)) - litIdx.begin();
+    for(auto & i : fresh.literalTokens_) i += static_cast<uint32_t>(firstOld);
+    splice(litIdx,litFirst,litLast,fresh.literalTokens_);
+    splice(tokens.literals_,litFirst,litLast,fresh.literals_);
+    for(size_t i = litFirst + fresh.literalTokens_.size() ; i < litIdx.size() ; i++) {
+        litIdx[i] = static_cast<uint32_t>(litIdx[i] + indexDelta);
+    }
+
+    //行首表：删去被替换区间内换行产生的行首，插入新文本的行首，其后平移
+    std::vector<uint32_t> newLines;
+    for(size_t i = 0 ; i < edit.inserted.size() ; i++) {
+        if(edit.inserted[i] == u8'\n') newLines.push_back(static_cast<uint32_t>(edit.offset + i + 1));
+    }
+    auto & lines = tokens.lineStarts_;
+    size_t lineFirst = std::upper_bound(lines.begin(),lines.end(),static_cast<uint32_t>(edit.offset)) - lines.begin();
+    size_t lineLast = std::upper_bound(lines.begin(),lines.end(),static_cast<uint32_t>(oldEditEnd)) - lines.begin();
+    splice(lines,lineFirst,lineLast,newLines);
+    for(size_t i = lineFirst + newLines.size() ; i < lines.size() ; i++) {
+        lines[i] = static_cast<uint32_t>(lines[i] + delta);
     }
+
+    tokens.source_ = std::move(source);
+    RelexResult ret;
+    ret.rescanBegin = restart;
+    ret.rescanEnd = st;
+    ret.removedTokens = lastOld - firstOld;
+    ret.insertedTokens = fresh.kinds_.size();
     return ret;
+}
 
+TokenList Scanner::scanParallel(std::u8string u8input, size_t threadCount) const {
+    return scanParallel(LCMPFileIO::SourceFile::fromString(std::move(u8input)),threadCount);
 }
 
-mScanner_ret scannerAgentU8(const std::u8string & u8input ,const std::string & input ,  size_t start_index)
-{
-    auto u8head = [](uint8_t ch) -> int {
-        int char_len;
-        if ((ch & 0x80) == 0x00) {        // 1-byte
-                char_len = 1;
-        } else if ((ch & 0xE0) == 0xC0) {  // 2-byte
-            char_len = 2;
-        } else if ((ch & 0xF0) == 0xE0) {  // 3-byte
-            char_len = 3;
-        } else if ((ch & 0xF8) == 0xF0) {  // 4-byte
-            char_len = 4;
-        } else {
-            std::cerr<<"Scanner Decode UTF8 ERROR";
-        }
-        return char_len;
-    };
-    mScanner_ret ret;
-    if(start_index == input.size())
-    {
-        ret.type = "EOF";
-        ret.value = "EOF";
-        return ret;
+TokenList Scanner::scanParallel(SourcePtr source, size_t threadCount) const {
+    constexpr size_t minChunk = 1u << 20;
+    if(threadCount == 0) {
+        threadCount = std::max<size_t>(1,std::thread::hardware_concurrency());
     }
-    int lastloc = start_index-1; //上一个合法的字符末尾index（含）
-    size_t curr_index = start_index;
-    state curr_state = mSTART;
-    std::function<void(void)> scanner = [&u8head,&input,&start_index,&lastloc,&ret,&curr_index,&curr_state,&scanner] {
-        uint8_t ch = input[curr_index];
-        int char_len = u8head(ch);
-        if(char_len == 1)
-        {
-            //std::cout<<ch;
-            if(move[curr_state][ch] == -1) {
-                return;
-            }
-            //移动
-            curr_state = move[curr_state][ch];
-            if(nodes[curr_state].acce)
-            {
-                ret.type = nodes[curr_state].type;
-                ret.value = ret.value + input.substr(lastloc+1,curr_index - lastloc); //拼接字符串
-                lastloc = curr_index;
-            }
-            curr_index++;
-            scanner();
-            return;
+    threadCount = std::min(threadCount,source->size() / minChunk);
+    if(threadCount <= 1) {
+        return scan(std::move(source));
+    }
+    TokenList ret = beginList(std::move(source));
+    const std::u8string_view input(ret.source_->view());
+
+    //切分点：名义位置之后的第一个同步字节，token不会跨越它
+    std::vector<size_t> cuts = {0};
+    for(size_t i = 1 ; i < threadCount ; i++) {
+        size_t pos = std::max(cuts.back(),input.size() / threadCount * i);
+        while(pos < input.size() && !syncByte_[static_cast<uint8_t>(input[pos])]) pos++;
+        cuts.push_back(pos);
+    }
+    cuts.push_back(input.size());
+
+    std::vector<TokenList> parts(threadCount);
+    {
+        std::vector<std::jthread> workers;
+        for(size_t i = 1 ; i < threadCount ; i++) {
+            workers.emplace_back([this,&parts,&cuts,input,i]() {
+                scanRange(input.substr(0,cuts[i+1]),cuts[i],parts[i]);
+            });
         }
-        else {
-            if(ret.value.empty()) {
-                //新进来U8符合 ID
-                ret.type = "ID";
-                ret.value = ret.value + input.substr(lastloc+1 ,curr_index + char_len-1 - lastloc);
-                curr_state = mID;
-                lastloc = curr_index + char_len - 1;
-            }
-            else {
-                char c = ret.value[0];
-                if(u8head(uint8_t(c)) > 1) 
-                {
-                    ret.type = "ID";
-                    ret.value = ret.value + input.substr(lastloc+1 ,curr_index + char_len -1  - lastloc);
-                    curr_state = mID;
-                    lastloc = curr_index + char_len - 1;
-                }
-                else if( ('a' <= c && c <= 'z' ) || ('A' <= c && c <= 'Z') ) {
-                    ret.type = "ID";
-                    ret.value = ret.value + input.substr(lastloc+1 ,curr_index + char_len -1 - lastloc);
-                    curr_state = mID;
-                    lastloc = curr_index + char_len - 1;
-                }
-                else {
-                    //非合法ID
-                    return;
-                }
-            }
-            curr_index += char_len; 
-            if(curr_index >= input.length()) return;
-            scanner();
-            return;
+        scanRange(input.substr(0,cuts[1]),0,parts[0]);
+    }
+
+    //按序拼接，旁路数组中的token下标加上前面各段的token数
+    size_t total = 0;
+    size_t totalLiterals = 0;
+    for(const auto & part : parts) {
+        total += part.kinds_.size();
+        totalLiterals += part.literals_.size();
+    }
+    ret.kinds_.reserve(total + 1);
+    ret.begins_.reserve(total + 1);
+    ret.lengths_.reserve(total + 1);
+    ret.literalTokens_.reserve(totalLiterals);
+    ret.literals_.reserve(totalLiterals);
+    for(auto & part : parts) {
+        uint32_t base = static_cast<uint32_t>(ret.kinds_.size());
+        ret.kinds_.insert(ret.kinds_.end(),part.kinds_.begin(),part.kinds_.end());
+        ret.begins_.insert(ret.begins_.end(),part.begins_.begin(),part.begins_.end());
+        ret.lengths_.insert(ret.lengths_.end(),part.lengths_.begin(),part.lengths_.end());
+        for(uint32_t idx : part.literalTokens_) {
+            ret.literalTokens_.push_back(base + idx);
         }
-        
-    };
-    scanner();
-    ret.next_start = lastloc+1;
-    if(lastloc < start_index)
-    {
-        //没有成功推进
-        ret.type="ERR";
-        ret.value = input[start_index];
-        ret.next_start = start_index+1;
+        ret.literals_.insert(ret.literals_.end(),part.literals_.begin(),part.literals_.end());
+        part = TokenList();
     }
+    finishList(ret);
     return ret;
+}
 
+size_t Scanner::kindCount() const {
+    return kindNames_->size();
 }
 
-void init_Lexer() {
+std::u8string_view Scanner::kindName(TokenKind kind) const {
+    return kindNames_->at(kind);
+}
 
-    if(LexerInit) {
-        return;
+TokenList scan(std::u8string u8input) {
+    return Scanner::defaultScanner().scan(std::move(u8input));
+}
+
+TokenList scan(SourcePtr source) {
+    return Scanner::defaultScanner().scan(std::move(source));
+}
+
+RelexResult relex(TokenList & tokens, const TextEdit & edit) {
+    return Scanner::defaultScanner().relex(tokens,edit);
+}
+
+size_t kindCount() {
+    return Scanner::defaultScanner().kindCount();
+}
+
+std::u8string_view kindName(TokenKind kind) {
+    return Scanner::defaultScanner().kindName(kind);
+}
+
+TokenStream::TokenStream(std::u8string u8input)
+    : TokenStream(Scanner::defaultScanner(),std::move(u8input))
+{
+}
+
+TokenStream::TokenStream(const Scanner & scanner, std::u8string u8input)
+    : TokenStream(scanner,LCMPFileIO::SourceFile::fromString(std::move(u8input)))
+{
+}
+
+TokenStream::TokenStream(SourcePtr source)
+    : TokenStream(Scanner::defaultScanner(),std::move(source))
+{
+}
+
+TokenStream::TokenStream(const Scanner & scanner, SourcePtr source)
+    : scanner_(scanner), source_(scanner.adoptSource(std::move(source)))
+{
+    advance();
+}
+
+void TokenStream::setObserver(Observer observer) {
+    observer_ = std::move(observer);
+    //已就位的第一个token补报
+    if(observer_ && index_ == 0) observer_(current_,index_);
+}
+
+scannerToken_t TokenStream::next() {
+    scannerToken_t ret = current_;
+    if(current_.kind != kindEND) {
+        index_++;
+        advance();
     }
-    memset(move,-1,sizeof(move));
-    for(int i = 0 ; i<60 ; i++)
+    return ret;
+}
+
+void TokenStream::advance() {
+    const std::u8string_view input(source_->view());
+    while(1)
     {
-        nodes[i].acce = false;
-        nodes[i].type = "";
+        if(scanner_.skipSpaceRun_) pos_ = SimdScan::skipSpace(input,pos_);
+        auto lexret = scanner_.matchToken(input,pos_);
+        if(lexret.kind == kindEOF) {
+            begin_ = input.size();
+            current_ = {kindEND,u8"END",u8"$"};
+            literal_.reset();
+            break;
+        }
+        size_t st = pos_;
+        pos_ = lexret.next_start;
+        if(lexret.kind == kindSKIP) continue;
+        begin_ = st;
+        auto text = input.substr(st,lexret.next_start - st);
+        current_ = {lexret.kind,(*scanner_.kindNames_)[lexret.kind],text};
+        literal_.reset();
+        if(lexret.kind == scanner_.numKind_ || lexret.kind == scanner_.floKind_) {
+            literal_ = scanner_.parseLiteral(lexret.kind,text);
+        }
+        break;
+    }
+    //统计到token起点为止的换行
+    const char8_t * data = input.data();
+    while(countedTo_ < begin_) {
+        auto nl = static_cast<const char8_t *>(std::memchr(data + countedTo_,'\n',begin_ - countedTo_));
+        if(!nl) break;
+        line_++;
+        lineStart_ = nl - data + 1;
+        countedTo_ = lineStart_;
     }
-    
-    insert_word_key(wordkey); //插入会跟ID有接触的
-    insert_noWord_key(skey); //插入跟ID没关系的
-    insert_id(); //id = [a-zA-Z][a-zA-Z0-9]*
-    insert_num(); // num = [+-]?[0-9]+
-    insert_flo(); // FLO = [+-]?[0-9]*.[0-9]+|[+-]?[0-9].[0-9]*
-    LexerInit = true;
+    countedTo_ = begin_;
+    if(observer_) observer_(current_,index_);
+}
 
+PipelinedTokenStream::PipelinedTokenStream(std::u8string u8input, TokenStream::Observer observer, size_t ringBatches)
+    : PipelinedTokenStream(Scanner::defaultScanner(),std::move(u8input),std::move(observer),ringBatches)
+{
 }
 
+PipelinedTokenStream::PipelinedTokenStream(const Scanner & scanner, std::u8string u8input, TokenStream::Observer observer, size_t ringBatches)
+    : PipelinedTokenStream(scanner,LCMPFileIO::SourceFile::fromString(std::move(u8input)),std::move(observer),ringBatches)
+{
+}
 
+PipelinedTokenStream::PipelinedTokenStream(SourcePtr source, TokenStream::Observer observer, size_t ringBatches)
+    : PipelinedTokenStream(Scanner::defaultScanner(),std::move(source),std::move(observer),ringBatches)
+{
+}
 
-/**
- * @attention 确保末尾加上[END,$]
- */
-std::vector<scannerToken_t> scan(const std::u8string & u8input) {
-    init_Lexer();
-    try
-    {
-        auto len = u8len(u8input); //非合法utf8编码出错会throw
+PipelinedTokenStream::PipelinedTokenStream(const Scanner & scanner, SourcePtr source, TokenStream::Observer observer, size_t ringBatches)
+    : stream_(scanner,std::move(source)), source_(stream_.sourceBuffer()), ring_(ringBatches)
+{
+    //首个token的回调也发生在此线程启动之前，之后只由扫描线程调用
+    if(observer) stream_.setObserver(std::move(observer));
+    producer_ = std::jthread([this](std::stop_token stop) { produce(stop); });
+    fetch();
+}
+
+PipelinedTokenStream::~PipelinedTokenStream() {
+    producer_.request_stop();
+    if(producer_.joinable()) producer_.join();
+}
+
+void PipelinedTokenStream::produce(std::stop_token stop) {
+    bool done = false;
+    while(!done) {
+        Batch * batch = ring_.beginWrite();
+        if(!batch) {
+            producerStalls_.fetch_add(1,std::memory_order_relaxed);
+            while(!(batch = ring_.beginWrite())) {
+                if(stop.stop_requested()) return;
+                std::this_thread::yield();
+            }
+        }
+        batch->count = 0;
+        batch->last = false;
+        while(batch->count < batchSize) {
+            auto & it = batch->items[batch->count++];
+            it.token = stream_.peek();
+            it.line = stream_.line();
+            it.column = stream_.column();
+            it.literal = stream_.literal();
+            if(it.token.kind == kindEND) {
+                batch->last = true;
+                done = true;
+                break;
+            }
+            stream_.next();
+        }
+        ring_.commitWrite();
     }
-    catch(const std::exception& e)
-    {
-        std::cerr << e.what() << '\n';
+}
+
+void PipelinedTokenStream::fetch() {
+    batch_ = ring_.beginRead();
+    if(!batch_) {
+        consumerStalls_++;
+        while(!(batch_ = ring_.beginRead())) {
+            std::this_thread::yield();
+        }
     }
-    
-    std::vector<scannerToken_t> ret;
-    size_t st = 0;
-    const std::string input = toString(u8input);
-    while(1)
-    {
-        auto lexret= scannerAgentU8(u8input,input,st);
-        if(lexret.type != "SKIP" && lexret.type != "EOF" ) {
-            ret.emplace_back(toU8str(lexret.type),toU8str(lexret.value));
-            //std::cout<<"("<<lexret.type<<",\""<<lexret.value<<"\")";
-        }   
-        if(lexret.type == "EOF") break;
-        st = lexret.next_start;
+    batches_++;
+    pos_ = 0;
+}
+
+scannerToken_t PipelinedTokenStream::next() {
+    scannerToken_t ret = peek();
+    if(ret.kind == kindEND) {
+        return ret;
+    }
+    index_++;
+    if(++pos_ == batch_->count) {
+        //END所在批次不会走到这里，生产者结束前必然还有后续批次
+        ring_.commitRead();
+        fetch();
     }
-    ret.push_back({u8"END",u8"$"});
-    
     return ret;
 }
 
+PipelineStats PipelinedTokenStream::stats() const {
+    PipelineStats ret;
+    ret.batches = batches_;
+    ret.producerStalls = producerStalls_.load(std::memory_order_relaxed);
+    ret.consumerStalls = consumerStalls_;
+    return ret;
+}
+
+scannerToken_t TokenList::operator[](size_t i) const {
+    TokenKind k = kinds_[i];
+    if(k == kindEND) {
+        return {kindEND,u8"END",u8"$"};
+    }
+    return {k,(*kindNames_)[k],source_->view().substr(begins_[i],lengths_[i])};
+}
+
+size_t TokenList::line(size_t i) const {
+    return std::upper_bound(lineStarts_.begin(),lineStarts_.end(),begins_[i]) - lineStarts_.begin();
+}
+
+size_t TokenList::column(size_t i) const {
+    return begins_[i] - lineStarts_[line(i) - 1] + 1;
+}
+
+std::optional<TokenLiteral> TokenList::literal(size_t i) const {
+    auto it = std::lower_bound(literalTokens_.begin(),literalTokens_.end(),static_cast<uint32_t>(i));
+    if(it == literalTokens_.end() || *it != i) {
+        return std::nullopt;
+    }
+    return literals_[it - literalTokens_.begin()];
+}
+
+size_t TokenList::memoryBytes() const {
+    return kinds_.size() * sizeof(TokenKind)
+         + (begins_.size() + lengths_.size() + lineStarts_.size() + literalTokens_.size()) * sizeof(uint32_t)
+         + literals_.size() * sizeof(TokenLiteral);
+}
+
 int test_main_u8()
 {
     std::string myprogram = R"(
@@ -432,38 +668,164 @@ int test_main_u8()
 }
 
 
+/**
+ * @brief 词法吞吐基准：缩进多、标识符长的机器生成代码，分别以各级SIMD实现扫描并比对结果
+ */
+int test_main_lexbench()
+{
+    std::u8string line = u8"                int generatedIdentifierNumber12345 = anotherVeryLongGeneratedName67890 * 1234567 + 3.14159;\n"
+                         u8"                if(generatedIdentifierNumber12345 < 99999999) print generatedIdentifierNumber12345;\n";
+    std::u8string program;
+    while(program.size() < (32u << 20)) program += line;
+    const double mb = program.size() / (1024.0 * 1024.0);
+
+    const auto detected = SimdScan::detectedLevel();
+    TokenList reference;
+    for(auto lv : {SimdScan::Level::Scalar,SimdScan::Level::SSE2,SimdScan::Level::AVX2})
+    {
+        if(static_cast<int>(lv) > static_cast<int>(detected)) break;
+        SimdScan::setLevel(lv);
+        auto start = std::chrono::high_resolution_clock::now();
+        auto tokens = scan(program);
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout<<SimdScan::levelName(lv)<<": "<<tokens.size()<<" tokens, "
+                 <<mb / seconds<<" MB/s, "<<tokens.size() / seconds / 1e6<<" Mtokens/s, "
+                 <<static_cast<double>(tokens.memoryBytes()) / tokens.size()<<" bytes/token\n";
+        if(reference.size() == 0) {
+            reference = std::move(tokens);
+            continue;
+        }
+        bool same = tokens.size() == reference.size();
+        for(size_t i = 0 ; same && i < tokens.size() ; i++) {
+            same = tokens[i].kind == reference[i].kind && tokens[i].value == reference[i].value;
+        }
+        if(!same) {
+            std::cerr<<"lexbench: "<<SimdScan::levelName(lv)<<" 结果与标量实现不一致\n";
+            return 1;
+        }
+    }
+    SimdScan::setLevel(detected);
+
+    const auto & scanner = Scanner::defaultScanner();
+    auto start = std::chrono::high_resolution_clock::now();
+    auto tokens = scanner.scanParallel(program);
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout<<"parallel("<<std::thread::hardware_concurrency()<<" threads): "<<mb / seconds<<" MB/s\n";
+    bool same = tokens.size() == reference.size();
+    for(size_t i = 0 ; same && i < tokens.size() ; i++) {
+        same = tokens[i].kind == reference[i].kind && tokens.offset(i) == reference.offset(i)
+            && tokens[i].value == reference[i].value && tokens.literal(i) == reference.literal(i);
+    }
+    if(!same) {
+        std::cerr<<"lexbench: 并行扫描结果与串行不一致\n";
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 多线程同时首次使用默认扫描器并扫描，结果须与单线程一致
+ */
+int test_main_threads()
+{
+    std::u8string program;
+    for(int i = 0 ; i < 2000 ; i++) {
+        program += u8"int 变量" + toU8str(std::to_string(i)) + u8" = " + toU8str(std::to_string(i)) + u8" * 2.5 + x;\n";
+    }
+    constexpr int threadCount = 8;
+    std::vector<TokenList> results(threadCount);
+    {
+        std::vector<std::jthread> workers;
+        for(int t = 0 ; t < threadCount ; t++) {
+            workers.emplace_back([&results,&program,t]() { results[t] = scan(program); });
+        }
+    }
+    //另建一个独立的扫描器，与默认扫描器并存
+    Scanner own(LexerGen::parseLexRules(defaultTerminalsText));
+    auto reference = own.scan(program);
+    for(const auto & tokens : results) {
+        bool same = tokens.size() == reference.size();
+        for(size_t i = 0 ; same && i < tokens.size() ; i++) {
+            same = tokens[i].type == reference[i].type && tokens[i].value == reference[i].value;
+        }
+        if(!same) {
+            std::cerr<<"test_main_threads: 并发扫描结果不一致\n";
+            return 1;
+        }
+    }
+    std::cout<<"test_main_threads: "<<threadCount<<" threads, "<<reference.size()<<" tokens each, ok\n";
+    return 0;
+}
+
+int test_main_relex()
+{
+    const std::vector<std::u8string> pieces = {
+        u8"int",u8"float",u8"while",u8"whilex",u8"x1",u8"变量",u8" ",u8"  ",u8"\n",u8"\t",u8"12",u8"3.5",u8".",
+        u8"+",u8"-",u8"*",u8"&&",u8"&",u8"|",u8"||",u8"==",u8"<=",u8"<",u8"=",u8";",u8"(",u8")",u8"{",u8"}",u8"#",u8"$",
+    };
+    std::mt19937 rng(20240611);
+    auto pick = [&rng](size_t n) { return static_cast<size_t>(rng() % n); };
+    auto randomText = [&](size_t count) {
+        std::u8string ret;
+        for(size_t i = 0 ; i < count ; i++) ret += pieces[pick(pieces.size())];
+        return ret;
+    };
+    auto sameList = [](const TokenList & a, const TokenList & b) {
+        if(a.size() != b.size() || a.source() != b.source()) return false;
+        for(size_t i = 0 ; i < a.size() ; i++) {
+            if(a.kind(i) != b.kind(i) || a[i].value != b[i].value || a.offset(i) != b.offset(i)
+               || a.line(i) != b.line(i) || a.column(i) != b.column(i) || a.literal(i) != b.literal(i)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    size_t edits = 0;
+    size_t rescanned = 0;
+    size_t sourceBytes = 0;
+    for(int round = 0 ; round < 20 ; round++) {
+        std::u8string text = randomText(2000);
+        auto tokens = scan(text);
+        for(int e = 0 ; e < 200 ; e++) {
+            TextEdit edit;
+            //编辑落在UTF-8字符边界上，避免校验告警刷屏
+            auto boundary = [&text](size_t pos) {
+                while(pos < text.size() && (text[pos] & 0xC0) == 0x80) pos++;
+                return pos;
+            };
+            edit.offset = boundary(pick(text.size() + 1));
+            edit.removed = boundary(std::min(edit.offset + pick(8),text.size())) - edit.offset;
+            std::u8string inserted = randomText(pick(4));
+            edit.inserted = inserted;
+            auto r = relex(tokens,edit);
+            text.replace(edit.offset,edit.removed,inserted);
+            if(!sameList(tokens,scan(text))) {
+                std::cerr<<"test_main_relex: 第"<<round<<"轮第"<<e<<"次编辑后与全量扫描不一致, offset "<<edit.offset
+                         <<" removed "<<edit.removed<<" inserted \""<<toString(inserted)<<"\"\n";
+                return 1;
+            }
+            edits++;
+            rescanned += r.rescanEnd - r.rescanBegin;
+            sourceBytes += text.size();
+        }
+    }
+    std::cout<<"test_main_relex: "<<edits<<" edits ok, 平均重扫 "<<static_cast<double>(rescanned) / edits
+             <<" 字节 / 平均源码 "<<static_cast<double>(sourceBytes) / edits<<" 字节\n";
+    return 0;
+}
+
 int test_main2()
 {
-    init_Lexer();
-    std::string myprogram = R"(
-    int raw(int x;) {
-        y=x+5;
-        return y};
-    void foo(int y;) {
-        int z;
-        void bar(int x; int soo();) {
-        if(x>3) bar(x/3,soo(),) else z = soo(x);
-        print z};
-        bar(y,raw(),)};
-    foo(6,)
-    )";
-    std::string myprogram2 = R"(
-    1
-    5
-    id if 485 841.6541 www
-    )";
-    std::string myprogram3 = R"(
+    std::u8string myprogram3 = u8R"(
     while(true){int a=0;}
     )";
-    size_t st = 0;
-    while(1)
-    {
-        auto lexret= scannerAgent(myprogram3,st);
-        if(lexret.type != "SKIP")   std::cout<<"("<<lexret.type<<",\""<<lexret.value<<"\")";
-        if(lexret.type == "EOF") break;
-        st = lexret.next_start;
+    for(auto q : scan(myprogram3)) {
+        std::cout<<"("<<toString_view(q.type)<<",\""<<toString_view(q.value)<<"\")";
     }
-    return 0;   
+    return 0;
 }
 
 } // namespace Lexer
@@ -0,0 +1,600 @@
+#include"lexerGen.h"
+#include"lcmpfileio.h"
+#include"stringUtil.h"
+#include<bitset>
+#include<map>
+#include<deque>
+#include<fstream>
+#include<sstream>
+#include<stdexcept>
+#include<algorithm>
+
+namespace LexerGen
+{
+
+namespace {
+
+struct NfaState {
+    std::bitset<256> chars;     //字符边的字节集合，目标为next
+    int next = -1;
+    std::vector<int> eps;       //ε边
+    int acceptRule = -1;
+};
+
+struct Fragment {
+    int start;
+    int end;
+};
+
+/**
+ * @brief 递归下降解析模式，直接以Thompson构造产出NFA片段
+ */
+class RegexParser {
+public:
+    RegexParser(std::vector<NfaState> & nfa_, std::u8string_view pattern_) : nfa(nfa_), pat(pattern_) {}
+
+    Fragment parse() {
+        Fragment f = parseAlt();
+        skipSpace();
+        if(pos != pat.size()) {
+            error("多余的')'");
+        }
+        return f;
+    }
+
+private:
+    std::vector<NfaState> & nfa;
+    std::u8string_view pat;
+    size_t pos = 0;
+
+    [[noreturn]] void error(const char * msg) const {
+        throw std::runtime_error(std::string("词法模式错误: ") + msg + " , 模式: " + toString(pat));
+    }
+    int newState() {
+        nfa.emplace_back();
+        return static_cast<int>(nfa.size() - 1);
+    }
+    void skipSpace() {
+        while(pos < pat.size() && (pat[pos] == u8' ' || pat[pos] == u8'\t')) pos++;
+    }
+    bool peek(char8_t c) {
+        skipSpace();
+        return pos < pat.size() && pat[pos] == c;
+    }
+    Fragment charSet(const std::bitset<256> & set) {
+        int s = newState();
+        int e = newState();
+        nfa[s].chars = set;
+        nfa[s].next = e;
+        return {s,e};
+    }
+
+    Fragment parseAlt() {
+        Fragment f = parseConcat();
+        while(peek(u8'|')) {
+            pos++;
+            Fragment g = parseConcat();
+            int s = newState();
+            int e = newState();
+            nfa[s].eps = {f.start, g.start};
+            nfa[f.end].eps.push_back(e);
+            nfa[g.end].eps.push_back(e);
+            f = {s,e};
+        }
+        return f;
+    }
+
+    Fragment parseConcat() {
+        std::optional<Fragment> f;
+        while(true) {
+            skipSpace();
+            if(pos >= pat.size() || pat[pos] == u8'|' || pat[pos] == u8')') break;
+            Fragment g = parseRepeat();
+            if(!f) {
+                f = g;
+            } else {
+                nfa[f->end].eps.push_back(g.start);
+                f->end = g.end;
+            }
+        }
+        if(!f) {
+            //空串
+            int s = newState();
+            int e = newState();
+            nfa[s].eps.push_back(e);
+            return {s,e};
+        }
+        return *f;
+    }
+
+    Fragment parseRepeat() {
+        Fragment f = parseAtom();
+        while(true) {
+            skipSpace();
+            if(pos >= pat.size()) break;
+            char8_t op = pat[pos];
+            if(op != u8'*' && op != u8'+' && op != u8'?') break;
+            pos++;
+            int s = newState();
+            int e = newState();
+            nfa[s].eps.push_back(f.start);
+            nfa[f.end].eps.push_back(e);
+            if(op != u8'+') nfa[s].eps.push_back(e);            // * ? 可跳过
+            if(op != u8'?') nfa[f.end].eps.push_back(f.start);  // * + 可重复
+            f = {s,e};
+        }
+        return f;
+    }
+
+    Fragment parseAtom() {
+        skipSpace();
+        if(pos >= pat.size()) {
+            error("模式意外结束");
+        }
+        char8_t c = pat[pos];
+        if(c == u8'(') {
+            pos++;
+            Fragment f = parseAlt();
+            if(!peek(u8')')) {
+                error("缺少')'");
+            }
+            pos++;
+            return f;
+        }
+        if(c == u8'[') {
+            pos++;
+            return charSet(parseClass());
+        }
+        if(c == u8'*' || c == u8'+' || c == u8'?') {
+            error("闭包缺少操作数");
+        }
+        std::bitset<256> set;
+        set.set(parseChar());
+        return charSet(set);
+    }
+
+    static int hexValue(char8_t c) {
+        if(u8'0' <= c && c <= u8'9') return c - u8'0';
+        if(u8'a' <= c && c <= u8'f') return c - u8'a' + 10;
+        if(u8'A' <= c && c <= u8'F') return c - u8'A' + 10;
+        return -1;
+    }
+
+    uint8_t parseChar() {
+        char8_t c = pat[pos++];
+        if(c != u8'\\') {
+            return c;
+        }
+        if(pos >= pat.size()) {
+            error("转义意外结束");
+        }
+        char8_t e = pat[pos++];
+        switch (e)
+        {
+        case u8'n': return '\n';
+        case u8't': return '\t';
+        case u8'r': return '\r';
+        case u8'x':
+        {
+            if(pos + 2 > pat.size() || hexValue(pat[pos]) < 0 || hexValue(pat[pos+1]) < 0) {
+                error("\\x需要两位十六进制数");
+            }
+            int v = hexValue(pat[pos]) * 16 + hexValue(pat[pos+1]);
+            pos += 2;
+            return static_cast<uint8_t>(v);
+        }
+        default:
+            return e;
+        }
+    }
+
+    std::bitset<256> parseClass() {
+        std::bitset<256> set;
+        bool negate = false;
+        if(pos < pat.size() && pat[pos] == u8'^') {
+            negate = true;
+            pos++;
+        }
+        bool first = true;
+        while(true) {
+            if(pos >= pat.size()) {
+                error("缺少']'");
+            }
+            if(pat[pos] == u8']' && !first) {
+                pos++;
+                break;
+            }
+            first = false;
+            uint8_t lo = parseChar();
+            uint8_t hi = lo;
+            if(pos + 1 < pat.size() && pat[pos] == u8'-' && pat[pos+1] != u8']') {
+                pos++;
+                hi = parseChar();
+            }
+            if(hi < lo) {
+                error("字符类区间颠倒");
+            }
+            for(int ch = lo ; ch <= hi ; ch++) {
+                set.set(ch);
+            }
+        }
+        if(negate) set.flip();
+        return set;
+    }
+};
+
+/**
+ * @brief 原地求ε闭包，结果有序
+ */
+void epsilonClosure(const std::vector<NfaState> & nfa, std::vector<int> & set, std::vector<char> & mark) {
+    std::vector<int> stack(set.begin(),set.end());
+    for(int s : set) mark[s] = 1;
+    while(!stack.empty()) {
+        int s = stack.back();
+        stack.pop_back();
+        for(int t : nfa[s].eps) {
+            if(!mark[t]) {
+                mark[t] = 1;
+                set.push_back(t);
+                stack.push_back(t);
+            }
+        }
+    }
+    for(int s : set) mark[s] = 0;
+    std::sort(set.begin(),set.end());
+}
+
+/**
+ * @brief 按NFA字符边把256个字节划分为等价类
+ */
+std::array<uint8_t,256> computeByteClasses(const std::vector<NfaState> & nfa, size_t & classCount) {
+    std::vector<std::bitset<256>> sets;
+    for(const auto & st : nfa) {
+        if(st.next != -1 && std::find(sets.begin(),sets.end(),st.chars) == sets.end()) {
+            sets.push_back(st.chars);
+        }
+    }
+    std::map<std::vector<bool>,uint8_t> signatureClass;
+    std::array<uint8_t,256> classOf{};
+    for(int b = 0 ; b < 256 ; b++) {
+        std::vector<bool> sig(sets.size());
+        for(size_t i = 0 ; i < sets.size() ; i++) {
+            sig[i] = sets[i][b];
+        }
+        auto [it,inserted] = signatureClass.emplace(std::move(sig),static_cast<uint8_t>(signatureClass.size()));
+        classOf[b] = it->second;
+    }
+    classCount = signatureClass.size();
+    return classOf;
+}
+
+/**
+ * @brief Hopcroft最小化，返回每个状态所属的块
+ * @param delta 完全DFA的转移 delta[s*classCount+c]
+ */
+std::vector<int> hopcroft(const std::vector<int> & delta, const std::vector<int32_t> & acceptTag, size_t classCount) {
+    const size_t n = acceptTag.size();
+    //逆转移
+    std::vector<std::vector<std::vector<int>>> inverse(classCount,std::vector<std::vector<int>>(n));
+    for(size_t s = 0 ; s < n ; s++) {
+        for(size_t c = 0 ; c < classCount ; c++) {
+            inverse[c][delta[s*classCount + c]].push_back(static_cast<int>(s));
+        }
+    }
+    //初始划分：按接受标记
+    std::vector<int> block(n);
+    std::vector<std::vector<int>> blocks;
+    std::map<int32_t,int> tagBlock;
+    for(size_t s = 0 ; s < n ; s++) {
+        auto [it,inserted] = tagBlock.emplace(acceptTag[s],static_cast<int>(blocks.size()));
+        if(inserted) blocks.emplace_back();
+        block[s] = it->second;
+        blocks[it->second].push_back(static_cast<int>(s));
+    }
+    std::deque<int> work;
+    std::vector<char> inWork(blocks.size(),1);
+    for(size_t b = 0 ; b < blocks.size() ; b++) work.push_back(static_cast<int>(b));
+
+    std::vector<char> inX(n,0);
+    std::vector<int> touchedCount;
+    while(!work.empty()) {
+        int A = work.front();
+        work.pop_front();
+        inWork[A] = 0;
+        const std::vector<int> splitter = blocks[A];
+        for(size_t c = 0 ; c < classCount ; c++) {
+            std::vector<int> X;
+            for(int t : splitter) {
+                for(int s : inverse[c][t]) {
+                    if(!inX[s]) {
+                        inX[s] = 1;
+                        X.push_back(s);
+                    }
+                }
+            }
+            if(X.empty()) continue;
+            touchedCount.assign(blocks.size(),0);
+            std::vector<int> touched;
+            for(int s : X) {
+                if(touchedCount[block[s]]++ == 0) touched.push_back(block[s]);
+            }
+            for(int Y : touched) {
+                if(static_cast<size_t>(touchedCount[Y]) == blocks[Y].size()) continue;
+                //分裂 Y -> Y∩X , Y\X
+                std::vector<int> inter;
+                std::vector<int> rest;
+                for(int s : blocks[Y]) {
+                    (inX[s] ? inter : rest).push_back(s);
+                }
+                int newBlock = static_cast<int>(blocks.size());
+                blocks[Y] = std::move(rest);
+                blocks.push_back(std::move(inter));
+                for(int s : blocks[newBlock]) block[s] = newBlock;
+                inWork.push_back(0);
+                if(inWork[Y]) {
+                    work.push_back(newBlock);
+                    inWork[newBlock] = 1;
+                } else {
+                    int smaller = blocks[Y].size() <= blocks[newBlock].size() ? Y : newBlock;
+                    work.push_back(smaller);
+                    inWork[smaller] = 1;
+                }
+            }
+            for(int s : X) inX[s] = 0;
+        }
+    }
+    return block;
+}
+
+} // namespace
+
+
+std::u8string escapeLiteral(std::u8string_view literal) {
+    const std::u8string_view special = u8"\\|()[]*+? \t";
+    std::u8string ret;
+    for(char8_t c : literal) {
+        if(special.find(c) != std::u8string_view::npos) {
+            ret.push_back(u8'\\');
+        }
+        ret.push_back(c);
+    }
+    return ret;
+}
+
+std::vector<LexRule> parseLexRules(std::string_view text) {
+    std::vector<LexRule> rules;
+    std::istringstream in{std::string(text)};
+    std::string line;
+    while(std::getline(in,line)) {
+        auto tokens = LCMPFileIO::splitTerminalLine(line);
+        if(tokens.size() < 2) continue;
+        LexRule rule;
+        rule.type = toU8str(tokens[0]);
+        if(tokens.size() >= 3 && !tokens[2].empty()) {
+            rule.pattern = toU8str(tokens[2]);
+        } else {
+            rule.pattern = escapeLiteral(toU8str(tokens[1]));
+        }
+        rules.push_back(std::move(rule));
+    }
+    //空白不是文法终结符，作为内置规则
+    rules.push_back({u8"SKIP",u8"[ \\t\\r\\n]"});
+    return rules;
+}
+
+std::vector<LexRule> readLexRules(const std::filesystem::path & terminalPath) {
+    std::ifstream file(terminalPath, std::ios::binary);
+    if(!file.is_open()) {
+        throw std::runtime_error("Failed to open terminal file");
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return parseLexRules(buffer.str());
+}
+
+namespace {
+
+/**
+ * @brief 由未排除的规则构造DFA，接受标记仍为原规则下标
+ */
+LexerTables buildDense(const std::vector<LexRule> & rules, const std::vector<char> & excluded, LexerStats * stats) {
+    //Thompson构造，所有规则并联到同一起点
+    std::vector<NfaState> nfa;
+    nfa.emplace_back();
+    for(size_t i = 0 ; i < rules.size() ; i++) {
+        if(excluded[i]) continue;
+        RegexParser parser(nfa,rules[i].pattern);
+        Fragment f = parser.parse();
+        nfa[0].eps.push_back(f.start);
+        nfa[f.end].acceptRule = static_cast<int>(i);
+    }
+
+    size_t classCount = 0;
+    auto classOf = computeByteClasses(nfa,classCount);
+    std::vector<uint8_t> representative(classCount);
+    for(int b = 255 ; b >= 0 ; b--) {
+        representative[classOf[b]] = static_cast<uint8_t>(b);
+    }
+
+    //子集构造
+    std::vector<char> mark(nfa.size(),0);
+    std::map<std::vector<int>,int> subsetId;
+    std::vector<std::vector<int>> subsets;
+    std::vector<int32_t> acceptTag;
+    DFA<int,int> subsetDFA(0,{});
+    auto internSubset = [&](std::vector<int> && set) -> int {
+        auto [it,inserted] = subsetId.emplace(set,static_cast<int>(subsets.size()));
+        if(inserted) {
+            int32_t tag = -1;
+            for(int s : set) {
+                if(nfa[s].acceptRule != -1 && (tag == -1 || nfa[s].acceptRule < tag)) {
+                    tag = nfa[s].acceptRule;
+                }
+            }
+            acceptTag.push_back(tag);
+            subsets.push_back(std::move(set));
+        }
+        return it->second;
+    };
+    {
+        std::vector<int> start = {0};
+        epsilonClosure(nfa,start,mark);
+        internSubset(std::move(start));
+    }
+    for(size_t i = 0 ; i < subsets.size() ; i++) {
+        for(size_t c = 0 ; c < classCount ; c++) {
+            std::vector<int> target;
+            for(int s : subsets[i]) {
+                if(nfa[s].next != -1 && nfa[s].chars[representative[c]] && !mark[nfa[s].next]) {
+                    mark[nfa[s].next] = 1;
+                    target.push_back(nfa[s].next);
+                }
+            }
+            for(int t : target) mark[t] = 0;
+            if(target.empty()) continue;
+            epsilonClosure(nfa,target,mark);
+            int id = internSubset(std::move(target));
+            subsetDFA.add_transition(static_cast<int>(i),static_cast<int>(c),id);
+        }
+    }
+
+    //补全为完全DFA（末尾为死状态）后最小化
+    const size_t n = subsets.size() + 1;
+    const int deadState = static_cast<int>(n - 1);
+    std::vector<int> delta(n * classCount,deadState);
+    for(size_t s = 0 ; s + 1 < n ; s++) {
+        for(size_t c = 0 ; c < classCount ; c++) {
+            auto t = subsetDFA.query_rule(static_cast<int>(s),static_cast<int>(c));
+            if(t) delta[s*classCount + c] = t.value();
+        }
+    }
+    std::vector<int32_t> completeTag = acceptTag;
+    completeTag.push_back(-1);
+    auto block = hopcroft(delta,completeTag,classCount);
+
+    //按BFS顺序为块编号，死状态所在块不编号
+    std::vector<int> blockState(n,-2);
+    std::vector<int> order;
+    blockState[block[deadState]] = -1;
+    if(block[0] != block[deadState]) {
+        blockState[block[0]] = 0;
+        order.push_back(0);
+    }
+    for(size_t i = 0 ; i < order.size() ; i++) {
+        for(size_t c = 0 ; c < classCount ; c++) {
+            int t = delta[order[i]*classCount + c];
+            if(blockState[block[t]] == -2) {
+                blockState[block[t]] = static_cast<int>(order.size());
+                order.push_back(t);
+            }
+        }
+    }
+    if(order.size() >= static_cast<size_t>(std::numeric_limits<int16_t>::max())) {
+        throw std::runtime_error("词法DFA状态过多");
+    }
+
+    //字符类再压缩：最小化后转移列完全相同的类合并
+    std::map<std::vector<int>,uint8_t> columnClass;
+    std::vector<uint8_t> remap(classCount);
+    for(size_t c = 0 ; c < classCount ; c++) {
+        std::vector<int> column(order.size());
+        for(size_t i = 0 ; i < order.size() ; i++) {
+            column[i] = blockState[block[delta[order[i]*classCount + c]]];
+        }
+        auto [it,inserted] = columnClass.emplace(std::move(column),static_cast<uint8_t>(columnClass.size()));
+        remap[c] = it->second;
+    }
+
+    LexerTables ret;
+    auto & dfa = ret.dfa;
+    dfa.classCount = columnClass.size();
+    for(int b = 0 ; b < 256 ; b++) {
+        dfa.classOf[b] = remap[classOf[b]];
+    }
+    dfa.table.assign(order.size() * dfa.classCount,DenseDFA<int16_t>::dead);
+    dfa.acceptTag.resize(order.size());
+    for(size_t i = 0 ; i < order.size() ; i++) {
+        dfa.acceptTag[i] = acceptTag[order[i]];
+        for(size_t c = 0 ; c < classCount ; c++) {
+            dfa.table[i*dfa.classCount + remap[c]] = static_cast<int16_t>(blockState[block[delta[order[i]*classCount + c]]]);
+        }
+    }
+    dfa.initial = 0;
+    for(const auto & rule : rules) {
+        ret.ruleTypes.push_back(rule.type);
+    }
+
+    if(stats) {
+        stats->nfaStates = nfa.size();
+        stats->dfaStates = subsets.size();
+        stats->minStates = order.size();
+        stats->classes = dfa.classCount;
+    }
+    return ret;
+}
+
+/**
+ * @brief 整串走完DFA后所在状态的接受标记，中途死亡返回-1
+ */
+int32_t acceptOf(const DenseDFA<int16_t> & dfa, std::u8string_view text) {
+    int16_t st = dfa.initial;
+    for(char8_t c : text) {
+        st = dfa.next(st,static_cast<uint8_t>(c));
+        if(st == dfa.dead) return -1;
+    }
+    return dfa.acceptTag[st];
+}
+
+} // namespace
+
+LexerTables generate(const std::vector<LexRule> & rules, LexerStats * stats, const KeywordTable * precomputed) {
+    //关键字候选：模式即字面量本身的规则，先不放入DFA
+    std::vector<char> excluded(rules.size(),0);
+    for(size_t i = 0 ; i < rules.size() ; i++) {
+        excluded[i] = isPlainWord(rules[i].pattern);
+    }
+    LexerTables ret = buildDense(rules,excluded,stats);
+
+    //候选须被某条靠后的规则（如ID）完整接受，词素查表才能还原原先的优先级；否则放回DFA
+    std::vector<int32_t> host(rules.size(),-1);
+    KeywordTable keywords;
+    bool rebuild = false;
+    for(size_t i = 0 ; i < rules.size() ; i++) {
+        if(!excluded[i]) continue;
+        bool shadowed = false;
+        for(size_t j = 0 ; j < i ; j++) {
+            if(host[j] != -1 && rules[j].pattern == rules[i].pattern) shadowed = true;
+        }
+        if(shadowed) continue;  //与靠前的关键字重复，永远不会命中
+        int32_t tag = acceptOf(ret.dfa,rules[i].pattern);
+        if(tag > static_cast<int32_t>(i) && keywords.add(rules[i].pattern,static_cast<int16_t>(i))) {
+            host[i] = tag;
+        } else {
+            excluded[i] = 0;
+            rebuild = true;
+        }
+    }
+    if(rebuild) {
+        ret = buildDense(rules,excluded,stats);
+    }
+
+    bool reuse = precomputed && precomputed->size() == keywords.size();
+    for(size_t k = 0 ; reuse && k < keywords.size() ; k++) {
+        reuse = precomputed->lookup(keywords[k].view()) == keywords[k].rule;
+    }
+    if(reuse) {
+        ret.keywords = *precomputed;
+    } else {
+        if(!keywords.build()) {
+            throw std::runtime_error("关键字完美哈希构造失败");
+        }
+        ret.keywords = keywords;
+    }
+    ret.keywordHost = std::move(host);
+    if(stats) {
+        stats->keywords = ret.keywords.size();
+    }
+    return ret;
+}
+
+} // namespace LexerGen
@@ -4,6 +4,7 @@
 #include <vector>
 #include <map>
 #include <fstream>
+#include <sstream>
 #include <optional>
 #include <charconv>
 #include <format>
@@ -11,6 +12,9 @@
 #include <algorithm>
 #include <variant>
 #include "parserGen.h"
+#include "parseTableFile.h"
+#include "lexerGen.h"
+#include "sourceFile.h"
 #include "asmGen.h"
 #include "AST/AST.h"
 
@@ -25,17 +29,31 @@ struct SLRParams {
     fs::path terminal_file;
     std::optional<fs::path> conflict_file;
     std::string output_name;
+    std::optional<fs::path> header_file;
+    std::optional<fs::path> direct_file;
+    LRMode mode = LRMode::SLR1;
+    size_t threads = 1;
 };
 
 struct ASTParams {
     fs::path input_file;
     std::optional<fs::path> param_file;
+    std::optional<fs::path> grammar_table;
     std::string output_name;
+    bool table_opt = false;
+    bool table_check = false;
+    bool direct = false;
+    bool parse_bench = false;
 };
 
 struct SParams {
     fs::path input_file;
+    std::optional<fs::path> grammar_table;
     std::string output_name;
+    bool parallel_lex = false;
+    bool pipelined_lex = false;
+    bool table_opt = false;
+    bool direct = false;
 };
 
 using CommandParams = std::variant<SLRParams, ASTParams, SParams>;
@@ -45,24 +63,37 @@ void print_help() {
 LCCompiler
 用法:
   1. SLR语法分析:
-    LCCompiler -slr <grammar文件> <terminal文件> [<SLR冲突解决文件>] -o=<输出文件名>
+    LCCompiler -slr <grammar文件> <terminal文件> [<SLR冲突解决文件>] -o=<输出文件名> [-header=<头文件>] [-direct=<头文件>] [-j=<线程数>]
+    LCCompiler -lalr <grammar文件> <terminal文件> [<SLR冲突解决文件>] -o=<输出文件名> [-header=<头文件>] [-direct=<头文件>] [-j=<线程数>]
+    LCCompiler -lr1 <grammar文件> <terminal文件> [<SLR冲突解决文件>] -o=<输出文件名> [-header=<头文件>] [-direct=<头文件>] [-j=<线程数>]
 
   2. 生成AST,若使用外置参数文件则生成通用AST结点:
-    LCCompiler -ast -i=<输入文件> [-p=<参数文件>] -o=<输出文件名>
+    LCCompiler -ast -i=<输入文件> [-p=<参数文件>|-g=<分析表文件>] -o=<输出文件名> [-tableopt|-tablecheck] [-direct|-parsebench]
 
   3. 生成汇编:
-    LCCompiler -s -i=<输入文件> -o=<输出文件名>
+    LCCompiler -s -i=<输入文件> [-g=<分析表文件>] -o=<输出文件名> [-lexpar|-lexpipe] [-tableopt] [-direct]
 
   4. 帮助:
     LCCompiler -h 或 LCCompiler --help
 
 选项说明:
   -slr     执行SLR语法分析
+  -lalr    以LALR(1)向前看符号生成分析表，并与SLR(1)对比冲突数
+  -lr1     以合并弱相容状态的LR(1)项目集生成分析表，并与SLR(1)对比状态数与冲突数
   -ast     执行AST处理
   -s       执行S处理
-  -i       指定输入文件
+  -i       指定输入文件，-i=- 读标准输入
   -p       指定参数文件(可选)
   -o       指定输出文件名(不含后缀)
+  -header  另将分析表写成constexpr数组的C++头文件，构建时以此把默认文法编译进程序
+  -direct  另将LR自动机直接编码为每个状态一个case的分析器头文件；用于-s/-ast时改用构建时生成的该分析器
+  -g       以.lcpt或.json分析表代替内置的默认文法
+  -j       按波次并行构造LR(0)项目集的线程数，默认为1即串行，-j=0取硬件线程数
+  -lexpar  先并行扫描出完整token数组再分析(大文件)，默认边扫描边分析
+  -lexpipe 扫描在独立线程进行，按批交给分析线程，并输出两端阻塞计数
+  -tableopt 分析表启用默认归约与单产生式旁路，并输出移进/归约步数
+  -tablecheck 分别用原分析表与优化后的分析表生成AST，比较输出并对比步数
+  -parsebench 分别用查表与直接编码的分析器生成AST，比较输出并对比耗时
   -h/--help 显示帮助信息
 )" << std::endl;
 }
@@ -82,13 +113,14 @@ std::optional<CommandParams> parse_args(int argc, const char* argv[]) {
 
     std::vector<std::string_view> args(argv + 2, argv + argc);
 
-    if (command == "-slr") {
+    if (command == "-slr" || command == "-lalr" || command == "-lr1") {
         if (args.size() < 3) {
             std::cerr << "错误: SLR命令需要至少3个参数\n";
             return std::nullopt;
         }
 
         SLRParams params;
+        params.mode = command == "-lalr" ? LRMode::LALR1 : command == "-lr1" ? LRMode::LR1 : LRMode::SLR1;
         size_t pos = 0;
 
         // 解析前两个必需文件参数
@@ -96,7 +128,7 @@ std::optional<CommandParams> parse_args(int argc, const char* argv[]) {
         params.terminal_file = args[pos++];
 
         // 检查第三个可选文件参数
-        if (pos < args.size() && !args[pos].starts_with("-o=")) {
+        if (pos < args.size() && !args[pos].starts_with("-")) {
             params.conflict_file = args[pos++];
         }
 
@@ -106,7 +138,19 @@ std::optional<CommandParams> parse_args(int argc, const char* argv[]) {
             if (args[pos].starts_with("-o=")) {
                 params.output_name = args[pos].substr(3);
                 output_found = true;
-                break;
+            }
+            else if (args[pos].starts_with("-header=")) {
+                params.header_file = args[pos].substr(8);
+            }
+            else if (args[pos].starts_with("-direct=")) {
+                params.direct_file = args[pos].substr(8);
+            }
+            else if (args[pos].starts_with("-j=")) {
+                auto num = args[pos].substr(3);
+                if (std::from_chars(num.data(), num.data() + num.size(), params.threads).ec != std::errc()) {
+                    std::cerr << "错误: 无效的线程数 " << num << "\n";
+                    return std::nullopt;
+                }
             }
         }
 
@@ -130,6 +174,21 @@ std::optional<CommandParams> parse_args(int argc, const char* argv[]) {
             else if (arg.starts_with("-p=")) {
                 params.param_file = arg.substr(3);
             }
+            else if (arg.starts_with("-g=")) {
+                params.grammar_table = arg.substr(3);
+            }
+            else if (arg == "-tableopt") {
+                params.table_opt = true;
+            }
+            else if (arg == "-tablecheck") {
+                params.table_check = true;
+            }
+            else if (arg == "-direct") {
+                params.direct = true;
+            }
+            else if (arg == "-parsebench") {
+                params.parse_bench = true;
+            }
             else if (arg.starts_with("-o=")) {
                 params.output_name = arg.substr(3);
                 output_found = true;
@@ -157,6 +216,21 @@ std::optional<CommandParams> parse_args(int argc, const char* argv[]) {
                 params.output_name = arg.substr(3);
                 output_found = true;
             }
+            else if (arg.starts_with("-g=")) {
+                params.grammar_table = arg.substr(3);
+            }
+            else if (arg == "-lexpar") {
+                params.parallel_lex = true;
+            }
+            else if (arg == "-lexpipe") {
+                params.pipelined_lex = true;
+            }
+            else if (arg == "-tableopt") {
+                params.table_opt = true;
+            }
+            else if (arg == "-direct") {
+                params.direct = true;
+            }
         }
 
         if (!input_found || !output_found) {
@@ -175,9 +249,10 @@ std::optional<CommandParams> parse_args(int argc, const char* argv[]) {
 
 void process_slr(const SLRParams& params) {
     std::cout << std::format(
-        "SLR配置生成:\n"
+        "{}配置生成:\n"
         "语法文件: {}\n"
         "终结符文件: {}\n",
+        params.mode == LRMode::LALR1 ? "LALR" : params.mode == LRMode::LR1 ? "LR(1)" : "SLR",
         params.grammar_file.string(),
         params.terminal_file.string()
     );
@@ -191,11 +266,34 @@ void process_slr(const SLRParams& params) {
     auto astbase = parserGen(
         params.grammar_file,
         params.terminal_file,
-        params.conflict_file
+        params.conflict_file,
+        params.mode,
+        params.threads
     );
 
+    auto packed = ParseTable::build(astbase.actionTable,astbase.gotoTable,astbase.symtab,astbase.Productions);
+    std::cout<<std::format("压缩分析表: 状态 {} , 符号 {} , 有效表项 {} , 稠密 {} 项 , 压缩后 {} 项\n",
+        packed.stateCount(),packed.symbolCount(),packed.entryCount(),packed.stateCount() * packed.symbolCount(),packed.packedSize());
+
+    //同一份终结符文件的模式列生成词法DFA，报告规模
+    LexerGen::LexerStats lexStats;
+    auto lexTables = LexerGen::generate(LexerGen::readLexRules(params.terminal_file),&lexStats);
+    std::cout<<std::format("词法DFA: NFA状态 {} , DFA状态 {} , 最小化后 {} , 字符类 {} , 转移表 {} 字节 , 哈希识别关键字 {}\n",
+        lexStats.nfaStates,lexStats.dfaStates,lexStats.minStates,lexStats.classes,lexTables.dfa.tableBytes(),lexStats.keywords);
+
     std::string output_filename = params.output_name + ".json";
-    std::cout<<std::format("输出文件: {}.json {}goto.tsv {}action.tsv\n",params.output_name,params.output_name,params.output_name);
+    std::cout<<std::format("输出文件: {}.json {}.lcpt {}goto.tsv {}action.tsv\n",params.output_name,params.output_name,params.output_name,params.output_name);
+    const uint64_t hash = LCMPFileIO::grammarHash(params.grammar_file,params.terminal_file,params.conflict_file,params.mode);
+    LCMPFileIO::writeParseTable(astbase,packed,hash,params.output_name+".lcpt");
+    if (params.header_file) {
+        LCMPFileIO::writeParseTableHeader(astbase,packed,hash,params.header_file.value(),"DefaultParseTable");
+        std::cout << "分析表头文件: " << params.header_file->string() << "\n";
+    }
+    if (params.direct_file) {
+        LCMPFileIO::writeDirectParserHeader(astbase,packed,hash,params.direct_file.value(),"DefaultDirectParser");
+        std::cout << "直接编码分析器: " << params.direct_file->string() << "\n";
+    }
+    std::cout<<std::format("文法指纹: {:016x}\n",hash);
 
     std::ofstream o(output_filename);
     nlohmann::json j = astbase;
@@ -212,6 +310,37 @@ void process_slr(const SLRParams& params) {
     
 }
 
+/**
+ * @brief 未指定分析表时使用编译进程序的默认文法，启动时不读文件也不解析JSON
+ * @param table .lcpt映射后直接使用，其他后缀按-slr输出的JSON解析
+ * @throws std::runtime_error 分析表文件无法打开或已损坏
+ */
+AST::AbstractSyntaxTree loadGrammar(const std::optional<fs::path> & table) {
+    if(!table) {
+        return AST::AbstractSyntaxTree(LCMPFileIO::builtinParseTable());
+    }
+    if(table->extension() == ".lcpt") {
+        return AST::AbstractSyntaxTree(LCMPFileIO::ParseTableFile::open(table.value()));
+    }
+    std::ifstream file(table.value());
+    if(!file) {
+        throw std::runtime_error("无法打开分析表文件: " + table->string());
+    }
+    nlohmann::json j2;
+    file >> j2;  // 从文件流解析
+    return AST::AbstractSyntaxTree(j2.get<ASTbaseContent>());
+}
+
+void print_table_opt(const ParseTable::OptimizeStats & st) {
+    std::cout << std::format("分析表优化: 默认归约状态 {} , 旁路单产生式的GOTO表项 {}\n",st.defaultStates,st.bypassedGotos);
+}
+
+void print_parse_steps(const AST::AbstractSyntaxTree & astT) {
+    const auto & st = astT.steps;
+    const double perToken = st.shifts ? double(st.shifts + st.reduces) / double(st.shifts) : 0.0;
+    std::cout << std::format("分析步数: 移进 {} , 归约 {} (默认归约 {}) , 每token {:.3f} 步\n",st.shifts,st.reduces,st.defaultReduces,perToken);
+}
+
 void process_ast(const ASTParams& params) {
     std::cout << std::format(
         "处理AST转换:\n"
@@ -223,28 +352,75 @@ void process_ast(const ASTParams& params) {
         std::cout << "参数文件: " << params.param_file->string() << "\n";
     }
 
-    nlohmann::json j2;
+    auto ss = Lexer::scan(LCMPFileIO::SourceFile::open(params.input_file));
     if (params.param_file) {
+        nlohmann::json j2;
         std::ifstream file(params.param_file.value());
         file >> j2;  // 从文件流解析
-    }
-    else {
-        std::ifstream file("defaultGrammar.json");
-        file >> j2;  // 从文件流解析
-    }
-    ASTbaseContent astbase2 = j2;
-    AST::AbstractSyntaxTree astT(astbase2);    
-    std::string program;
-    program = readFileToString(params.input_file);
-    auto ss = Lexer::scan(toU8str(program));
-    if (params.param_file) {
+        ASTbaseContent astbase2 = j2;
+        AST::AbstractSyntaxTree astT(astbase2);
         astT.BuildCommonAST(ss);
         AST::mVisitor v;
         astT.root->accept(v);
     }
     else {
+        AST::AbstractSyntaxTree astT = loadGrammar(params.grammar_table);
         std::ofstream ofile(params.output_name+".ast");
-        astT.BuildSpecifiedAST(ss);
+        if (params.parse_bench) {
+            //同一token数组分别用查表与直接编码的分析器，各取多轮中最快的一次
+            constexpr int rounds = 5;
+            std::string dumps[2];
+            double best[2] = {0.0,0.0};
+            for (int k = 0 ; k < 2 ; k++) {
+                for (int r = 0 ; r < rounds ; r++) {
+                    auto t0 = std::chrono::steady_clock::now();
+                    bool ok = k == 0 ? astT.BuildSpecifiedAST(ss) : astT.BuildSpecifiedASTDirect(ss);
+                    std::chrono::duration<double,std::milli> dt = std::chrono::steady_clock::now() - t0;
+                    if (!ok) {
+                        return;
+                    }
+                    if (r == 0 || dt.count() < best[k]) best[k] = dt.count();
+                }
+                std::ostringstream os;
+                AST::ASTEnumTypeVisitor v(os);
+                astT.root->accept(v);
+                dumps[k] = os.str();
+            }
+            std::cout << std::format("语法分析: 查表 {:.3f} ms , 直接编码 {:.3f} ms\n",best[0],best[1]);
+            std::cout << (dumps[0] == dumps[1] ? "AST输出一致\n" : "AST输出不一致\n");
+            ofile << dumps[0];
+            return;
+        }
+        if (params.table_check) {
+            //同一token数组先后用两张表分析，AST输出须逐字节相同
+            std::ostringstream plain, optimized;
+            if (!astT.BuildSpecifiedAST(ss)) {
+                return;
+            }
+            AST::ASTEnumTypeVisitor v1(plain);
+            astT.root->accept(v1);
+            print_parse_steps(astT);
+            print_table_opt(astT.optimizeParseTable());
+            if (!astT.BuildSpecifiedAST(ss)) {
+                std::cerr << "优化后的分析表未能生成AST\n";
+                return;
+            }
+            AST::ASTEnumTypeVisitor v2(optimized);
+            astT.root->accept(v2);
+            print_parse_steps(astT);
+            std::cout << (plain.str() == optimized.str() ? "AST输出一致\n" : "AST输出不一致\n");
+            ofile << plain.str();
+            return;
+        }
+        if (params.table_opt) {
+            print_table_opt(astT.optimizeParseTable());
+        }
+        if (!(params.direct ? astT.BuildSpecifiedASTDirect(ss) : astT.BuildSpecifiedAST(ss))) {
+            return;
+        }
+        if (params.table_opt) {
+            print_parse_steps(astT);
+        }
         AST::ASTEnumTypeVisitor v2(ofile);
         astT.root->accept(v2);
     }
@@ -257,19 +433,20 @@ void process_s(const SParams& params) {
 
     auto start = std::chrono::high_resolution_clock::now();
 
-    std::ifstream file("defaultGrammar.json");
-    nlohmann::json j2;
-    file >> j2;  // 从文件流解析
-    ASTbaseContent astbase2 = j2;
-    AST::AbstractSyntaxTree astT(astbase2);
+    AST::AbstractSyntaxTree astT = loadGrammar(params.grammar_table);
+    if(params.table_opt) {
+        print_table_opt(astT.optimizeParseTable());
+    }
     
-    std::string program;
-    std::ifstream file2(params.input_file);
-    if(!file2.is_open()) {
+    //普通文件只读映射后直接交给词法器，-i=- 读标准输入
+    Lexer::SourcePtr source;
+    try {
+        source = LCMPFileIO::SourceFile::open(params.input_file);
+    }
+    catch(const std::runtime_error &) {
         std::cout<<"无法打开文件："<<params.input_file<<std::endl;
         return;
     }
-    program = readFileToString(params.input_file);
 
     std::ofstream tokenFile(params.output_name+".token");
     std::ofstream ASTFile(params.output_name+".astFile");
@@ -277,19 +454,49 @@ void process_s(const SParams& params) {
     std::ofstream ASMFile(params.output_name+".s");
     std::ofstream SymFile(params.output_name+".symTable");
 
-    auto ss = Lexer::scan(toU8str(program));
-    for(int i= 0 ;i < ss.size() ; i++) {
-        auto q = ss[i];
-        tokenFile<<"["<<toString(q.type)<<" "<<toString(q.value)<<" "<<i<<"]";
-        if(q.type == u8"ERR") {
-            std::cerr<<std::format("Lexer解析失败:无法解析的符号{}\n",toString_view(q.value));
-            return;
+    //AST中的字符串视图指向源码缓冲区，需存活到编译结束
+    Lexer::SourcePtr sourceBuffer;
+    bool ASTBuilt = false;
+    if(params.parallel_lex) {
+        //按同步点切分并行扫描，小文件内部退化为串行
+        auto ss = Lexer::Scanner::defaultScanner().scanParallel(std::move(source));
+        for(int i= 0 ;i < ss.size() ; i++) {
+            auto q = ss[i];
+            tokenFile<<"["<<toString(q.type)<<" "<<toString(q.value)<<" "<<i<<"]";
+            if(q.type == u8"ERR") {
+                std::cerr<<std::format("Lexer解析失败:无法解析的符号{} 位于{}行{}列\n",toString_view(q.value),ss.line(i),ss.column(i));
+                return;
+            }
         }
+        sourceBuffer = ss.sourceBuffer();
+        ASTBuilt = params.direct ? astT.BuildSpecifiedASTDirect(ss) : astT.BuildSpecifiedAST(ss);
+    }
+    else if(params.pipelined_lex) {
+        //扫描线程负责写.token文件，本线程只做移进/归约
+        Lexer::PipelinedTokenStream stream(std::move(source),[&tokenFile](const Lexer::scannerToken_t & q, size_t i) {
+            tokenFile<<"["<<toString(q.type)<<" "<<toString(q.value)<<" "<<i<<"]";
+        });
+        sourceBuffer = stream.sourceBuffer();
+        ASTBuilt = params.direct ? astT.BuildSpecifiedASTDirect(stream) : astT.BuildSpecifiedAST(stream);
+        auto st = stream.stats();
+        std::cout<<std::format("词法流水线: {}批, 扫描线程阻塞{}次, 分析线程阻塞{}次\n",st.batches,st.producerStalls,st.consumerStalls);
     }
-    if(!astT.BuildSpecifiedAST(ss)) {
+    else {
+        //边扫描边分析，token随取随写，不保留token数组
+        Lexer::TokenStream stream(std::move(source));
+        stream.setObserver([&tokenFile](const Lexer::scannerToken_t & q, size_t i) {
+            tokenFile<<"["<<toString(q.type)<<" "<<toString(q.value)<<" "<<i<<"]";
+        });
+        sourceBuffer = stream.sourceBuffer();
+        ASTBuilt = params.direct ? astT.BuildSpecifiedASTDirect(stream) : astT.BuildSpecifiedAST(stream);
+    }
+    if(!ASTBuilt) {
         std::cerr<<"AST生成失败\n"<<std::endl;
         return;
     }
+    if(params.table_opt) {
+        print_parse_steps(astT);
+    }
 
     Semantic::ASTContentVisitor v2(ASTFile);
     AST::ConstantFoldingVisitor v3;
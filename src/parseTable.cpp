@@ -0,0 +1,184 @@
+#include"parseTable.h"
+#include<algorithm>
+#include<numeric>
+#include<stdexcept>
+
+ParseTable ParseTable::build(
+    const std::vector<std::unordered_map<SymbolId, action>> & actionTable,
+    const std::vector<std::unordered_map<SymbolId, StateId>> & gotoTable,
+    const SymbolTable & symtab,
+    const std::unordered_map<ProductionId, Production> & Productions)
+{
+    struct Storage {
+        std::vector<int32_t> base, check, value, lhs, arity;
+    };
+    auto storage = std::make_shared<Storage>();
+    Storage & out = *storage;
+    size_t entries = 0;
+    const size_t symbolCount = symtab.symbols().size();
+    auto start = symtab.find_index(u8"START");
+    if(!start) {
+        throw std::invalid_argument("文法缺少增广开始符号START");
+    }
+
+    size_t prodCount = 0;
+    for(const auto & [pid,prod] : Productions) {
+        prodCount = std::max<size_t>(prodCount,pid + 1);
+    }
+    out.lhs.assign(prodCount,-1);
+    out.arity.assign(prodCount,0);
+    for(const auto & [pid,prod] : Productions) {
+        out.lhs[pid] = static_cast<int32_t>(prod.lhs());
+        out.arity[pid] = static_cast<int32_t>(prod.rhs().size());
+    }
+
+    //每行的(符号,表项)，ACTION与GOTO的列互不重叠
+    const size_t stateCount = std::max(actionTable.size(),gotoTable.size());
+    std::vector<std::vector<std::pair<size_t,int32_t>>> rows(stateCount);
+    for(size_t s = 0 ; s < actionTable.size() ; s++) {
+        for(const auto & [sym,act] : actionTable[s]) {
+            int32_t v = std::visit(overload {
+                [](StateId t) -> int32_t { return static_cast<int32_t>(t) + 1; },
+                [](ProductionId p) -> int32_t { return -static_cast<int32_t>(p) - 1; }
+            },act);
+            rows[s].emplace_back(sym,v);
+        }
+    }
+    for(size_t s = 0 ; s < gotoTable.size() ; s++) {
+        for(const auto & [sym,target] : gotoTable[s]) {
+            if(symtab[sym].is_terminal()) continue;
+            rows[s].emplace_back(sym,static_cast<int32_t>(target) + 1);
+        }
+    }
+
+    //表项多的行先放，首次适配
+    std::vector<size_t> order(stateCount);
+    std::iota(order.begin(),order.end(),size_t(0));
+    std::stable_sort(order.begin(),order.end(),[&rows](size_t a,size_t b) { return rows[a].size() > rows[b].size(); });
+    out.base.assign(stateCount,0);
+    //nextFree[i]指向i起的第一个空位（路径压缩），末项代表表尾之外；
+    //候选位移只取最小列落在空位上的，跳过的位移都不可行，结果与逐个位移试探相同
+    std::vector<size_t> nextFree(1,0);
+    auto findFree = [&nextFree](size_t i) {
+        if(i >= nextFree.size()) return i;
+        while(nextFree[i] != i) {
+            nextFree[i] = nextFree[nextFree[i]];
+            i = nextFree[i];
+        }
+        return i;
+    };
+    for(size_t s : order) {
+        const auto & row = rows[s];
+        entries += row.size();
+        if(row.empty()) continue;
+        const size_t firstFree = findFree(0);
+        const size_t minSym = std::min_element(row.begin(),row.end())->first;
+        size_t d = firstFree > minSym ? firstFree - minSym : 0;
+        for(;; d++) {
+            d = findFree(d + minSym) - minSym;
+            bool fits = std::all_of(row.begin(),row.end(),[&](const auto & e) {
+                return d + e.first >= out.check.size() || out.check[d + e.first] == -1;
+            });
+            if(fits) break;
+        }
+        if(d > static_cast<size_t>(INT32_MAX)) {
+            throw std::length_error("分析表过大");
+        }
+        out.base[s] = static_cast<int32_t>(d);
+        for(const auto & [sym,v] : row) {
+            if(d + sym >= out.check.size()) {
+                out.check.resize(d + sym + 1,-1);
+                out.value.resize(d + sym + 1,error);
+                for(size_t i = nextFree.size() ; i <= out.check.size() ; i++) nextFree.push_back(i);
+            }
+            out.check[d + sym] = static_cast<int32_t>(s);
+            out.value[d + sym] = v;
+            nextFree[d + sym] = d + sym + 1;
+        }
+    }
+    //任一状态以任一符号查表都不越界
+    size_t maxBase = out.base.empty() ? 0 : static_cast<size_t>(*std::max_element(out.base.begin(),out.base.end()));
+    if(out.check.size() < maxBase + symbolCount) {
+        out.check.resize(maxBase + symbolCount,-1);
+        out.value.resize(maxBase + symbolCount,error);
+    }
+    Arrays arrays{out.base,out.check,out.value,out.lhs,out.arity};
+    return view(arrays,static_cast<int32_t>(start.value()),symbolCount,entries,std::move(storage));
+}
+
+ParseTable ParseTable::view(Arrays arrays, int32_t startSymbol, size_t symbolCount, size_t entryCount, std::shared_ptr<const void> owner) {
+    ParseTable ret;
+    ret.base_ = arrays.base;
+    ret.check_ = arrays.check;
+    ret.value_ = arrays.value;
+    ret.lhs_ = arrays.lhs;
+    ret.arity_ = arrays.arity;
+    ret.owner_ = std::move(owner);
+    ret.startSymbol_ = startSymbol;
+    ret.symbolCount_ = symbolCount;
+    ret.entries_ = entryCount;
+    return ret;
+}
+
+ParseTable ParseTable::optimized(const SymbolTable & symtab, const std::vector<ProductionId> & forwarding, OptimizeStats * stats) const {
+    struct Storage {
+        std::vector<int32_t> value, defaults;
+    };
+    auto storage = std::make_shared<Storage>();
+    storage->value.assign(value_.begin(),value_.end());
+    storage->defaults.assign(stateCount(),error);
+    OptimizeStats local;
+
+    //默认归约：终结符列上的表项全是同一个归约，接受不在此列
+    for(size_t s = 0 ; s < stateCount() ; s++) {
+        int32_t only = error;
+        bool single = true;
+        for(const auto & sym : symtab.symbols()) {
+            if(!sym.is_terminal()) continue;
+            int32_t e = entry(StateId(s),SymbolId(sym.index()));
+            if(e == error) continue;
+            if(isShift(e) || (only != error && e != only)) {
+                single = false;
+                break;
+            }
+            only = e;
+        }
+        if(single && only != error && !isAccept(reduceProd(only))) {
+            storage->defaults[s] = only;
+            local.defaultStates++;
+        }
+    }
+
+    //单产生式旁路
+    std::vector<char> forwards(productionCount(),0);
+    for(ProductionId pid : forwarding) {
+        if(pid < productionCount() && arity(pid) == 1) forwards[pid] = 1;
+    }
+    for(size_t s = 0 ; s < stateCount() ; s++) {
+        for(const auto & sym : symtab.symbols()) {
+            if(sym.is_terminal()) continue;
+            const size_t i = static_cast<size_t>(base_[s]) + sym.index();
+            if(check_[i] != static_cast<int32_t>(s) || !isShift(value_[i])) continue;
+            StateId target = shiftTarget(value_[i]);
+            //单产生式成环时文法二义，步数上限防止死循环
+            for(size_t hop = 0 ; hop < stateCount() ; hop++) {
+                const int32_t d = storage->defaults[target];
+                if(d == error || !forwards[reduceProd(d)]) break;
+                const int32_t next = entry(StateId(s),SymbolId(lhs(reduceProd(d))));
+                if(!isShift(next)) break;
+                target = shiftTarget(next);
+            }
+            if(target != shiftTarget(value_[i])) {
+                storage->value[i] = static_cast<int32_t>(target) + 1;
+                local.bypassedGotos++;
+            }
+        }
+    }
+
+    ParseTable ret = view(Arrays{base_,check_,storage->value,lhs_,arity_},startSymbol_,symbolCount_,entries_,std::shared_ptr<const void>());
+    ret.defaults_ = storage->defaults;
+    //原表的存储同样要保持存活
+    ret.owner_ = std::make_shared<std::pair<std::shared_ptr<const void>,std::shared_ptr<Storage>>>(owner_,std::move(storage));
+    if(stats) *stats = local;
+    return ret;
+}
@@ -0,0 +1,513 @@
+#include"parseTableFile.h"
+#include"lcmpfileio.h"
+#include<cstring>
+#include<fstream>
+#include<sstream>
+#include<iomanip>
+#include<stdexcept>
+#include<algorithm>
+
+namespace LCMPFileIO
+{
+
+namespace {
+
+constexpr uint32_t byteOrderMark = 0x01020304;
+
+class Fnv1a {
+public:
+    void bytes(const void * data, size_t n) {
+        auto p = static_cast<const unsigned char *>(data);
+        for(size_t i = 0 ; i < n ; i++) {
+            h = (h ^ p[i]) * 0x100000001b3ull;
+        }
+    }
+    void str(std::u8string_view s) {
+        bytes(s.data(),s.size());
+        bytes("",1);
+    }
+    void u32(uint32_t v) { bytes(&v,sizeof(v)); }
+    template<typename T>
+    void section(std::span<const T> data) { bytes(data.data(),data.size_bytes()); }
+    uint64_t value() const { return h; }
+private:
+    uint64_t h = 0xcbf29ce484222325ull;
+};
+
+/**
+ * @brief 符号、产生式与字符串池各段的校验和，按写出时的原始字节计算
+ */
+uint64_t sectionChecksum(std::span<const ParseTableSymbol> symbols, std::span<const int32_t> lhs, std::span<const int32_t> arity,
+                         std::span<const uint32_t> rhsBegin, std::span<const uint32_t> rhs, std::u8string_view strings) {
+    Fnv1a h;
+    h.section(symbols);
+    h.section(lhs);
+    h.section(arity);
+    h.section(rhsBegin);
+    h.section(rhs);
+    h.str(strings);
+    return h.value();
+}
+
+/**
+ * @brief 写出前的各段，二进制文件与生成头文件共用
+ */
+struct Sections {
+    uint64_t grammarHash = 0;
+    int32_t startSymbol = -1;
+    uint32_t entryCount = 0;
+    std::vector<ParseTableSymbol> symbols;
+    std::vector<int32_t> lhs, arity;
+    std::vector<uint32_t> rhsBegin, rhs;
+    std::vector<int32_t> base, check, value;
+    std::vector<uint32_t> stateBegin, items;
+    std::u8string strings;
+};
+
+Sections collectSections(const ASTbaseContent & content, const ParseTable & table, uint64_t hash) {
+    if(content.states.size() != table.stateCount()) {
+        throw std::invalid_argument("分析表与项目集状态数不一致");
+    }
+    Sections out;
+    out.grammarHash = hash;
+    out.startSymbol = table.startSymbol();
+    out.entryCount = static_cast<uint32_t>(table.entryCount());
+
+    auto intern = [&out](std::u8string_view s) {
+        uint32_t offset = static_cast<uint32_t>(out.strings.size());
+        out.strings.append(s);
+        return offset;
+    };
+    for(const auto & sym : content.symtab.symbols()) {
+        ParseTableSymbol rec{};
+        rec.symLength = static_cast<uint32_t>(sym.sym().size());
+        rec.sym = intern(sym.sym());
+        rec.typeLength = static_cast<uint32_t>(sym.tokentype().size());
+        rec.type = intern(sym.tokentype());
+        rec.patternLength = static_cast<uint32_t>(sym.pattern().size());
+        rec.pattern = intern(sym.pattern());
+        rec.terminal = sym.is_terminal();
+        out.symbols.push_back(rec);
+    }
+
+    const auto arrays = table.arrays();
+    out.lhs.assign(arrays.lhs.begin(),arrays.lhs.end());
+    out.arity.assign(arrays.arity.begin(),arrays.arity.end());
+    out.base.assign(arrays.base.begin(),arrays.base.end());
+    out.check.assign(arrays.check.begin(),arrays.check.end());
+    out.value.assign(arrays.value.begin(),arrays.value.end());
+    out.rhsBegin.push_back(0);
+    for(size_t pid = 0 ; pid < out.lhs.size() ; pid++) {
+        auto it = content.Productions.find(ProductionId(pid));
+        if(it != content.Productions.end()) {
+            for(SymbolId x : it->second.rhs()) out.rhs.push_back(static_cast<uint32_t>(x));
+        }
+        out.rhsBegin.push_back(static_cast<uint32_t>(out.rhs.size()));
+    }
+    out.stateBegin.push_back(0);
+    for(const auto & state : content.states) {
+        for(const auto & item : state) {
+            out.items.push_back(static_cast<uint32_t>(item.producId));
+            out.items.push_back(static_cast<uint32_t>(item.dot_pos));
+        }
+        out.stateBegin.push_back(static_cast<uint32_t>(out.items.size() / 2));
+    }
+    return out;
+}
+
+/**
+ * @brief 按8字节对齐追加一段，返回其偏移
+ */
+template<typename T>
+uint64_t appendSection(std::string & out, const std::vector<T> & data) {
+    out.resize((out.size() + 7) & ~size_t(7),'\0');
+    uint64_t offset = out.size();
+    out.append(reinterpret_cast<const char *>(data.data()),data.size() * sizeof(T));
+    return offset;
+}
+
+template<typename T>
+void emitArray(std::ostream & os, std::string_view type, std::string_view name, const std::vector<T> & data) {
+    os << "inline constexpr std::array<" << type << "," << data.size() << "> " << name << " = {";
+    for(size_t i = 0 ; i < data.size() ; i++) {
+        if(i % 16 == 0) os << "\n    ";
+        os << data[i] << ",";
+    }
+    os << "\n};\n";
+}
+
+[[noreturn]] void corrupt(const std::string & origin, const char * what) {
+    throw std::runtime_error("分析表损坏: " + origin + " (" + what + ")");
+}
+
+} // namespace
+
+uint64_t grammarHash(const std::filesystem::path & grammar, const std::filesystem::path & terminals,
+                     const std::optional<std::filesystem::path> & conflict, LRMode mode) {
+    Fnv1a h;
+    h.str(SourceFile::open(grammar)->view());
+    h.str(SourceFile::open(terminals)->view());
+    h.str(conflict ? SourceFile::open(conflict.value())->view() : std::u8string_view());
+    h.u32(static_cast<uint32_t>(mode));
+    return h.value();
+}
+
+void writeParseTable(const ASTbaseContent & content, const ParseTable & table, uint64_t hash, const std::filesystem::path & path) {
+    const Sections s = collectSections(content,table,hash);
+    ParseTableHeader header{};
+    std::memcpy(header.magic,"LCPT",4);
+    header.version = parseTableVersion;
+    header.byteOrder = byteOrderMark;
+    header.symbolCount = static_cast<uint32_t>(s.symbols.size());
+    header.productionCount = static_cast<uint32_t>(s.lhs.size());
+    header.stateCount = static_cast<uint32_t>(s.base.size());
+    header.packedSize = static_cast<uint32_t>(s.value.size());
+    header.entryCount = s.entryCount;
+    header.startSymbol = s.startSymbol;
+    header.rhsCount = static_cast<uint32_t>(s.rhs.size());
+    header.itemCount = static_cast<uint32_t>(s.items.size() / 2);
+    header.stringBytes = static_cast<uint32_t>(s.strings.size());
+    header.grammarHash = s.grammarHash;
+    header.checksum = sectionChecksum(s.symbols,s.lhs,s.arity,s.rhsBegin,s.rhs,s.strings);
+
+    std::string out(sizeof(header),'\0');
+    header.symbolsOffset = appendSection(out,s.symbols);
+    header.lhsOffset = appendSection(out,s.lhs);
+    header.arityOffset = appendSection(out,s.arity);
+    header.rhsBeginOffset = appendSection(out,s.rhsBegin);
+    header.rhsOffset = appendSection(out,s.rhs);
+    header.baseOffset = appendSection(out,s.base);
+    header.checkOffset = appendSection(out,s.check);
+    header.valueOffset = appendSection(out,s.value);
+    header.stateBeginOffset = appendSection(out,s.stateBegin);
+    header.itemsOffset = appendSection(out,s.items);
+    header.stringsOffset = appendSection(out,std::vector<char8_t>(s.strings.begin(),s.strings.end()));
+    std::memcpy(out.data(),&header,sizeof(header));
+
+    std::ofstream file(path,std::ios::binary | std::ios::trunc);
+    if(!file) {
+        throw std::runtime_error("无法写入文件: " + path.string());
+    }
+    file.write(out.data(),static_cast<std::streamsize>(out.size()));
+}
+
+void writeParseTableHeader(const ASTbaseContent & content, const ParseTable & table, uint64_t hash, const std::filesystem::path & path, std::string_view ns) {
+    const Sections s = collectSections(content,table,hash);
+    std::ostringstream os;
+    os << "// 由分析表生成器根据grammar.txt、terminal.txt与SLR冲突解决文件生成，请勿手动修改\n"
+       << "#pragma once\n"
+       << "#include<array>\n"
+       << "#include<cstdint>\n"
+       << "#include\"parseTableFile.h\"\n\n"
+       << "namespace " << ns << "\n{\n\n"
+       << "inline constexpr uint64_t grammarHash = 0x" << std::hex << std::setw(16) << std::setfill('0') << s.grammarHash << std::dec << "ull;\n"
+       << "inline constexpr int32_t startSymbol = " << s.startSymbol << ";\n"
+       << "inline constexpr uint32_t entryCount = " << s.entryCount << ";\n\n";
+
+    os << "inline constexpr std::array<LCMPFileIO::ParseTableSymbol," << s.symbols.size() << "> symbols = {{\n";
+    for(const auto & rec : s.symbols) {
+        os << "    {" << rec.sym << "," << rec.symLength << "," << rec.type << "," << rec.typeLength << ","
+           << rec.pattern << "," << rec.patternLength << "," << rec.terminal << ",0},";
+        //注释只写可打印ASCII的符号名，反斜杠会续行
+        std::u8string_view name = std::u8string_view(s.strings).substr(rec.sym,rec.symLength);
+        if(std::all_of(name.begin(),name.end(),[](char8_t c) { return c >= 0x20 && c < 0x7f && c != '\\'; })) {
+            os << " // " << std::string_view(reinterpret_cast<const char *>(name.data()),name.size());
+        }
+        os << "\n";
+    }
+    os << "}};\n";
+    emitArray(os,"int32_t","lhs",s.lhs);
+    emitArray(os,"int32_t","arity",s.arity);
+    emitArray(os,"uint32_t","rhsBegin",s.rhsBegin);
+    emitArray(os,"uint32_t","rhs",s.rhs);
+    emitArray(os,"int32_t","base",s.base);
+    emitArray(os,"int32_t","check",s.check);
+    emitArray(os,"int32_t","value",s.value);
+    emitArray(os,"uint32_t","stateBegin",s.stateBegin);
+    emitArray(os,"uint32_t","items",s.items);
+
+    //字符串池逐字节写成八进制转义，避免与后续字符连读
+    os << "inline constexpr std::u8string_view strings = std::u8string_view(u8\"";
+    for(size_t i = 0 ; i < s.strings.size() ; i++) {
+        if(i != 0 && i % 32 == 0) os << "\"\n    u8\"";
+        os << '\\' << std::oct << std::setw(3) << std::setfill('0') << static_cast<unsigned>(s.strings[i]) << std::dec;
+    }
+    os << "\"," << s.strings.size() << ");\n\n";
+    os << "} // namespace " << ns << "\n";
+
+    std::ofstream file(path,std::ios::binary | std::ios::trunc);
+    if(!file) {
+        throw std::runtime_error("无法写入文件: " + path.string());
+    }
+    file << os.str();
+}
+
+void writeDirectParserHeader(const ASTbaseContent & content, const ParseTable & table, uint64_t hash, const std::filesystem::path & path, std::string_view ns) {
+    const auto & symbols = content.symtab.symbols();
+    //注释只写可打印ASCII，反斜杠会续行
+    auto comment = [](std::u8string_view text) -> std::string {
+        if(!std::all_of(text.begin(),text.end(),[](char8_t c) { return c >= 0x20 && c < 0x7f && c != '\\'; })) return {};
+        return " // " + std::string(reinterpret_cast<const char *>(text.data()),text.size());
+    };
+    auto prodText = [&](ProductionId pid) {
+        std::u8string text(content.symtab[SymbolId(table.lhs(pid))].sym());
+        text += u8" ->";
+        auto it = content.Productions.find(pid);
+        if(it != content.Productions.end()) {
+            for(SymbolId x : it->second.rhs()) {
+                text += u8" ";
+                text += content.symtab[x].sym();
+            }
+        }
+        return text;
+    };
+
+    std::ostringstream os;
+    os << "// 由分析表生成器根据grammar.txt、terminal.txt与SLR冲突解决文件生成，请勿手动修改\n"
+       << "#pragma once\n"
+       << "#include<cstddef>\n"
+       << "#include<cstdint>\n"
+       << "#include<vector>\n\n"
+       << "namespace " << ns << "\n{\n\n"
+       << "inline constexpr uint64_t grammarHash = 0x" << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec << "ull;\n"
+       << "inline constexpr uint32_t stateCount = " << table.stateCount() << ";\n"
+       << "inline constexpr uint32_t noState = UINT32_MAX;   //GOTO表中没有的转移\n\n";
+
+    //每个非终结符一个GOTO函数
+    for(const auto & sym : symbols) {
+        if(sym.is_terminal()) continue;
+        os << "inline uint32_t goto" << sym.index() << "(uint32_t state) {" << comment(sym.sym()) << "\n"
+           << "    switch(state) {\n";
+        for(size_t s = 0 ; s < table.stateCount() ; s++) {
+            const int32_t e = table.entry(StateId(s),SymbolId(sym.index()));
+            if(ParseTable::isShift(e)) os << "    case " << s << ": return " << ParseTable::shiftTarget(e) << ";\n";
+        }
+        os << "    default: return noState;\n"
+           << "    }\n"
+           << "}\n\n";
+    }
+
+    //每个产生式一个归约函数：先交给Driver建结点，再弹栈并按左部转移，没有转移时以左部报错
+    for(size_t pid = 0 ; pid < table.productionCount() ; pid++) {
+        if(table.isAccept(ProductionId(pid)) || content.Productions.find(ProductionId(pid)) == content.Productions.end()) continue;
+        const size_t arity = table.arity(ProductionId(pid));
+        os << "template<typename Driver>\n"
+           << "inline bool reduce" << pid << "(Driver & d, std::vector<uint32_t> & stack) {" << comment(prodText(ProductionId(pid))) << "\n"
+           << "    if(!d.reduce(" << pid << "," << arity << ")) return false;\n";
+        if(arity != 0) os << "    stack.resize(stack.size() - " << arity << ");\n";
+        os << "    const uint32_t next = goto" << table.lhs(ProductionId(pid)) << "(stack.back());\n"
+           << "    if(next == noState) {\n"
+           << "        d.error(stack.back()," << table.lhs(ProductionId(pid)) << ");\n"
+           << "        return false;\n"
+           << "    }\n"
+           << "    stack.push_back(next);\n"
+           << "    return true;\n"
+           << "}\n\n";
+    }
+
+    os << "/**\n"
+       << " * @brief 直接编码的LR分析器，栈顶即当前状态\n"
+       << " * @note Driver须提供: int32_t lookahead() 当前token的终结符，失败时为负; void shift();\n"
+       << " *       bool reduce(uint32_t prod, size_t arity); void accept(); void error(uint32_t state, int32_t sym)，\n"
+       << " *       归约后没有GOTO转移时error的sym为左部非终结符\n"
+       << " */\n"
+       << "template<typename Driver>\n"
+       << "bool parse(Driver & d) {\n"
+       << "    std::vector<uint32_t> stack;\n"
+       << "    stack.reserve(64);\n"
+       << "    stack.push_back(0);\n"
+       << "    while(true) {\n"
+       << "        const int32_t sym = d.lookahead();\n"
+       << "        if(sym < 0) return false;\n"
+       << "        switch(stack.back()) {\n";
+    for(size_t s = 0 ; s < table.stateCount() ; s++) {
+        //同一动作的终结符合并为一组case，按首次出现的顺序
+        std::vector<std::pair<int32_t,std::vector<size_t>>> groups;
+        for(const auto & sym : symbols) {
+            if(!sym.is_terminal()) continue;
+            const int32_t e = table.entry(StateId(s),SymbolId(sym.index()));
+            if(e == ParseTable::error) continue;
+            auto it = std::find_if(groups.begin(),groups.end(),[e](const auto & g) { return g.first == e; });
+            if(it == groups.end()) {
+                groups.emplace_back(e,std::vector<size_t>{});
+                it = groups.end() - 1;
+            }
+            it->second.push_back(sym.index());
+        }
+        os << "        case " << s << ":\n"
+           << "            switch(sym) {\n";
+        for(const auto & [e,syms] : groups) {
+            os << "            ";
+            for(size_t x : syms) os << "case " << x << ": ";
+            os << "\n";
+            if(ParseTable::isShift(e)) {
+                os << "                d.shift();\n"
+                   << "                stack.push_back(" << ParseTable::shiftTarget(e) << ");\n"
+                   << "                continue;\n";
+            }
+            else if(table.isAccept(ParseTable::reduceProd(e))) {
+                os << "                d.accept();\n"
+                   << "                return true;\n";
+            }
+            else {
+                os << "                if(!reduce" << ParseTable::reduceProd(e) << "(d,stack)) return false;\n"
+                   << "                continue;\n";
+            }
+        }
+        os << "            default: break;\n"
+           << "            }\n"
+           << "            break;\n";
+    }
+    os << "        default: break;\n"
+       << "        }\n"
+       << "        d.error(stack.back(),sym);\n"
+       << "        return false;\n"
+       << "    }\n"
+       << "}\n\n"
+       << "} // namespace " << ns << "\n";
+
+    std::ofstream file(path,std::ios::binary | std::ios::trunc);
+    if(!file) {
+        throw std::runtime_error("无法写入文件: " + path.string());
+    }
+    file << os.str();
+}
+
+void ParseTableFile::validate(const std::string & origin) const {
+    const ParseTableImage & m = image_;
+    const size_t symbolCount = m.symbols.size();
+    const size_t productionCount = m.lhs.size();
+    const size_t stateCount = m.base.size();
+    if(m.arity.size() != productionCount || m.rhsBegin.size() != productionCount + 1 ||
+       m.stateBegin.size() != stateCount + 1 || m.check.size() != m.value.size() || m.items.size() % 2 != 0) {
+        corrupt(origin,"段长度不一致");
+    }
+    //分析表查表不做边界检查，这里一次性确认
+    for(int32_t base : m.base) {
+        if(base < 0 || uint64_t(base) + symbolCount > m.value.size()) corrupt(origin,"base越界");
+    }
+    for(int32_t v : m.value) {
+        if((v > 0 && uint64_t(v) > stateCount) || (v < 0 && uint64_t(-int64_t(v)) > productionCount)) corrupt(origin,"表项越界");
+    }
+    for(int32_t lhs : m.lhs) {
+        if(lhs >= int32_t(symbolCount)) corrupt(origin,"产生式左部越界");
+    }
+    //左部为负的编号没有产生式，归约到它会以负的非终结符查GOTO表
+    for(int32_t v : m.value) {
+        if(v < 0 && m.lhs[-int64_t(v) - 1] < 0) corrupt(origin,"归约到不存在的产生式");
+    }
+    for(const auto & rec : m.symbols) {
+        for(auto [offset,length] : {std::pair{rec.sym,rec.symLength},{rec.type,rec.typeLength},{rec.pattern,rec.patternLength}}) {
+            if(uint64_t(offset) + length > m.strings.size()) corrupt(origin,"字符串越界");
+        }
+    }
+    if(!std::is_sorted(m.rhsBegin.begin(),m.rhsBegin.end()) || m.rhsBegin.back() > m.rhs.size()) corrupt(origin,"产生式右部越界");
+    for(size_t pid = 0 ; pid < productionCount ; pid++) {
+        if(m.arity[pid] != int32_t(m.rhsBegin[pid + 1] - m.rhsBegin[pid])) corrupt(origin,"产生式长度不符");
+    }
+    for(uint32_t x : m.rhs) {
+        if(x >= symbolCount) corrupt(origin,"产生式右部越界");
+    }
+    if(m.startSymbol < 0 || uint32_t(m.startSymbol) >= symbolCount) corrupt(origin,"开始符号越界");
+    if(!std::is_sorted(m.stateBegin.begin(),m.stateBegin.end()) || m.stateBegin.back() > m.items.size() / 2) corrupt(origin,"状态项目越界");
+}
+
+std::shared_ptr<const ParseTableFile> ParseTableFile::open(const std::filesystem::path & path) {
+    std::shared_ptr<ParseTableFile> ret(new ParseTableFile());
+    ret->file_ = SourceFile::open(path);
+    const auto bytes = ret->file_->view();
+    if(bytes.size() < sizeof(ParseTableHeader)) corrupt(path.string(),"文件头不完整");
+    ParseTableHeader h;
+    std::memcpy(&h,bytes.data(),sizeof(h));
+    if(std::memcmp(h.magic,"LCPT",4) != 0) corrupt(path.string(),"标识不符");
+    if(h.version != parseTableVersion) {
+        throw std::runtime_error("分析表文件版本不符: " + path.string());
+    }
+    if(h.byteOrder != byteOrderMark) {
+        throw std::runtime_error("分析表文件字节序不符: " + path.string());
+    }
+    //各段须对齐且不越界
+    auto fits = [&](uint64_t offset, uint64_t size, uint64_t align) {
+        return offset % align == 0 && offset <= bytes.size() && size <= bytes.size() - offset;
+    };
+    const bool ok =
+        fits(h.symbolsOffset,uint64_t(h.symbolCount) * sizeof(ParseTableSymbol),4) &&
+        fits(h.lhsOffset,uint64_t(h.productionCount) * 4,4) &&
+        fits(h.arityOffset,uint64_t(h.productionCount) * 4,4) &&
+        fits(h.rhsBeginOffset,(uint64_t(h.productionCount) + 1) * 4,4) &&
+        fits(h.rhsOffset,uint64_t(h.rhsCount) * 4,4) &&
+        fits(h.baseOffset,uint64_t(h.stateCount) * 4,4) &&
+        fits(h.checkOffset,uint64_t(h.packedSize) * 4,4) &&
+        fits(h.valueOffset,uint64_t(h.packedSize) * 4,4) &&
+        fits(h.stateBeginOffset,(uint64_t(h.stateCount) + 1) * 4,4) &&
+        fits(h.itemsOffset,uint64_t(h.itemCount) * 8,4) &&
+        fits(h.stringsOffset,h.stringBytes,1);
+    if(!ok) corrupt(path.string(),"段越界");
+
+    auto section = [&bytes]<typename T>(std::type_identity<T>, uint64_t offset, size_t count) {
+        return std::span<const T>(reinterpret_cast<const T *>(bytes.data() + offset),count);
+    };
+    ParseTableImage & m = ret->image_;
+    m.grammarHash = h.grammarHash;
+    m.startSymbol = h.startSymbol;
+    m.entryCount = h.entryCount;
+    m.symbols = section(std::type_identity<ParseTableSymbol>{},h.symbolsOffset,h.symbolCount);
+    m.lhs = section(std::type_identity<int32_t>{},h.lhsOffset,h.productionCount);
+    m.arity = section(std::type_identity<int32_t>{},h.arityOffset,h.productionCount);
+    m.rhsBegin = section(std::type_identity<uint32_t>{},h.rhsBeginOffset,h.productionCount + 1);
+    m.rhs = section(std::type_identity<uint32_t>{},h.rhsOffset,h.rhsCount);
+    m.base = section(std::type_identity<int32_t>{},h.baseOffset,h.stateCount);
+    m.check = section(std::type_identity<int32_t>{},h.checkOffset,h.packedSize);
+    m.value = section(std::type_identity<int32_t>{},h.valueOffset,h.packedSize);
+    m.stateBegin = section(std::type_identity<uint32_t>{},h.stateBeginOffset,h.stateCount + 1);
+    m.items = section(std::type_identity<uint32_t>{},h.itemsOffset,size_t(h.itemCount) * 2);
+    m.strings = bytes.substr(h.stringsOffset,h.stringBytes);
+    if(sectionChecksum(m.symbols,m.lhs,m.arity,m.rhsBegin,m.rhs,m.strings) != h.checksum) corrupt(path.string(),"校验和不符");
+    ret->validate(path.string());
+    return ret;
+}
+
+std::shared_ptr<const ParseTableFile> ParseTableFile::fromImage(const ParseTableImage & image) {
+    std::shared_ptr<ParseTableFile> ret(new ParseTableFile());
+    ret->image_ = image;
+    return ret;
+}
+
+ParseTable ParseTableFile::table() const {
+    ParseTable::Arrays arrays{image_.base,image_.check,image_.value,image_.lhs,image_.arity};
+    return ParseTable::view(arrays,image_.startSymbol,image_.symbols.size(),image_.entryCount,file_);
+}
+
+SymbolTable ParseTableFile::symbols() const {
+    SymbolTable ret;
+    auto str = [this](uint32_t offset, uint32_t length) {
+        return std::u8string(image_.strings.substr(offset,length));
+    };
+    for(const auto & rec : image_.symbols) {
+        ret.add_symbol(str(rec.sym,rec.symLength),str(rec.type,rec.typeLength),str(rec.pattern,rec.patternLength),rec.terminal != 0);
+    }
+    return ret;
+}
+
+std::unordered_map<ProductionId, Production> ParseTableFile::productions() const {
+    std::unordered_map<ProductionId, Production> ret;
+    for(size_t pid = 0 ; pid < image_.lhs.size() ; pid++) {
+        if(image_.lhs[pid] < 0) continue;
+        std::vector<SymbolId> body;
+        for(uint32_t i = image_.rhsBegin[pid] ; i < image_.rhsBegin[pid + 1] ; i++) {
+            body.push_back(SymbolId(image_.rhs[i]));
+        }
+        ret.emplace(ProductionId(pid),JsonConverter::Production_Construct_helper(NonTerminalId(image_.lhs[pid]),std::move(body),ProductionId(pid)));
+    }
+    return ret;
+}
+
+std::vector<dotProdc> ParseTableFile::stateItems(StateId state) const {
+    std::vector<dotProdc> ret;
+    for(uint32_t i = image_.stateBegin[state] ; i < image_.stateBegin[state + 1] ; i++) {
+        ret.push_back(dotProdc{image_.items[2 * i + 1],ProductionId(image_.items[2 * i])});
+    }
+    return ret;
+}
+
+} // namespace LCMPFileIO
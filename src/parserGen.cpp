@@ -6,310 +6,506 @@
 #include<cassert>
 #include<iostream>
 #include<unordered_set>
+#include<algorithm>
+#include<functional>
+#include<limits>
+#include<numeric>
+#include<deque>
+#include<array>
+#include<bit>
+#include<atomic>
+#include<memory>
+#include<mutex>
+#include<thread>
 #include<filesystem>
+#include<optional>
+#include<fstream>
 #include"parserGen.h"
 
 const std::u8string epsilon = u8"ε"; // 显式定义ε
 
 
-std::unordered_map<NonTerminalId, std::unordered_set<std::u8string>> computeFirst(
-    const SymbolTable& symtab,
-    const std::unordered_map<ProductionId, Production>& Productions) 
-{
-    std::unordered_map<NonTerminalId, std::unordered_set<std::u8string>> FIRST;
-    
-    // 初始化所有非终结符的FIRST集
-    for (auto ntid : symtab.nonTerminals()) {
-        FIRST[ntid] = {};
+namespace {
+
+//终结符集合，按终结符序号置位
+using TermSet = std::vector<uint64_t>;
+
+inline void setBit(TermSet & set, size_t bit) {
+    set[bit / 64] |= uint64_t(1) << (bit % 64);
+}
+
+inline bool unionInto(TermSet & dst, const TermSet & src) {
+    bool changed = false;
+    for (size_t w = 0; w < dst.size(); ++w) {
+        uint64_t merged = dst[w] | src[w];
+        changed |= merged != dst[w];
+        dst[w] = merged;
     }
-    bool changed;
-    size_t loop_count = 0;
-    
-    do {
-        changed = false;
-        for (const auto & [_, Prod] : Productions) {
-            auto ntid = NonTerminalId(Prod.lhs());
-            bool all_epsilon = true;
-            
-            for (const auto& rhsid : Prod.rhs()) {
-                const auto& sym = symtab[rhsid];
-                
-                if (sym.is_terminal()) {
-                    // 终结符直接加入FIRST集
-                    if (FIRST[ntid].insert(sym.sym()).second) {
-                        changed = true;
-                    }
-                    all_epsilon = false;
-                    break;
-                } else {
-                    // 非终结符的情况
-                    auto rhs_ntid = NonTerminalId(rhsid);
-                    // 避免直接左递归
-                    if (rhs_ntid == ntid) {
-                        if (FIRST[rhs_ntid].empty()) {
-                            all_epsilon = false;    
-                            break;
-                        }
-                        if (FIRST[rhs_ntid].count(epsilon) != 0) {
-                            continue;
-                        }
-                        else {
-                            all_epsilon = false;
-                            break;
-                        }  
-                    }
-                    // 添加非ε的符号
-                    for (const auto& h : FIRST[rhs_ntid]) {
-                        if (h != epsilon && FIRST[ntid].insert(h).second) {
-                            changed = true;
-                        }
-                    }
-                    // 如果不能推导出ε，就停止
-                    if (FIRST[rhs_ntid].count(epsilon) == 0) {
-                        all_epsilon = false;
-                        break;
-                    }
-                }
+    return changed;
+}
+
+inline bool intersects(const TermSet & a, const TermSet & b) {
+    for (size_t w = 0; w < a.size(); ++w) {
+        if (a[w] & b[w]) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 终结符与位序号的对应
+ */
+struct TerminalBits {
+    std::vector<size_t> bitOf;      //按SymbolId，非终结符为max
+    std::vector<SymbolId> termOf;
+    size_t words = 0;
+
+    explicit TerminalBits(const SymbolTable & symtab) {
+        const auto & symbols = symtab.symbols();
+        bitOf.assign(symbols.size(), std::numeric_limits<size_t>::max());
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            if (symbols[i].is_terminal()) {
+                bitOf[i] = termOf.size();
+                termOf.push_back(SymbolId(i));
             }
-            // 如果所有符号都能推导出ε，则加入ε
-            if (all_epsilon && FIRST[ntid].insert(epsilon).second) {
-                changed = true;
+        }
+        words = (termOf.size() + 63) / 64;
+    }
+    /**
+     * @brief 集合转为SymbolId列表，升序
+     */
+    std::vector<SymbolId> toSymbols(const TermSet & set) const {
+        std::vector<SymbolId> ret;
+        for (size_t w = 0; w < set.size(); ++w) {
+            for (uint64_t bitsLeft = set[w]; bitsLeft; bitsLeft &= bitsLeft - 1) {
+                ret.push_back(termOf[w * 64 + std::countr_zero(bitsLeft)]);
             }
         }
+        return ret;
+    }
+};
 
-        if (++loop_count > 50) {
-            std::cerr << "FIRST computation failed to converge after 50 iterations\n";
-            std::unreachable();
+/**
+ * @brief 可推导出ε的符号，按SymbolId
+ */
+std::vector<char> computeNullable(size_t symbolCount, const std::unordered_map<ProductionId, Production> & Productions) {
+    std::vector<char> nullable(symbolCount, 0);
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (const auto & [pid, prod] : Productions) {
+            if (nullable[prod.lhs()]) continue;
+            bool all = std::all_of(prod.rhs().begin(), prod.rhs().end(), [&](SymbolId x) { return nullable[x] != 0; });
+            if (all) nullable[prod.lhs()] = changed = true;
         }
-    } while (changed);
-    
-    return FIRST;
+    }
+    return nullable;
 }
 
-std::unordered_set<std::u8string> computeFirstOfSequence(
-    const SymbolTable& symtab,
-    const std::unordered_map<NonTerminalId, std::unordered_set<std::u8string>>& FIRST,
-    const std::vector<SymbolId>& sequence)
-{
-    std::unordered_set<std::u8string> result;
-    bool all_epsilon = true;
-    
-    for (const auto& symid : sequence) {
-        const auto& sym = symtab[symid];
-        if (sym.is_terminal()) {
-            result.insert(sym.sym());
-            all_epsilon = false;
-            break;
-        } else {
-            auto ntid = NonTerminalId(symid);
-            for (auto h : FIRST.at(ntid)) {
-                if (h != epsilon) result.insert(h);
-            }
-            if (FIRST.at(ntid).count(epsilon) == 0) {
-                all_epsilon = false;
-                break;
+/**
+ * @brief DeRemer-Pennello的digraph：F(x) = F(x) ∪ ⋃{F(y) | x R y}，强连通分量内的结点取相同结果
+ */
+class Digraph {
+public:
+    Digraph(const std::vector<std::vector<size_t>> & relation, std::vector<TermSet> & F)
+        : R(relation), F(F), N(relation.size(), 0) {}
+    void run() {
+        for (size_t x = 0; x < R.size(); ++x) {
+            if (N[x] == 0) traverse(x);
+        }
+    }
+private:
+    static constexpr size_t done = std::numeric_limits<size_t>::max();
+    const std::vector<std::vector<size_t>> & R;
+    std::vector<TermSet> & F;
+    std::vector<size_t> N;
+    std::vector<size_t> stack;
+
+    void traverse(size_t x) {
+        stack.push_back(x);
+        const size_t d = stack.size();
+        N[x] = d;
+        for (size_t y : R[x]) {
+            if (N[y] == 0) traverse(y);
+            N[x] = std::min(N[x], N[y]);
+            unionInto(F[x], F[y]);
+        }
+        if (N[x] == d) {
+            while (true) {
+                size_t top = stack.back();
+                stack.pop_back();
+                N[top] = done;
+                if (top == x) break;
+                F[top] = F[x];
             }
         }
     }
-    if (all_epsilon) {
-        result.insert(epsilon);
+};
+
+/**
+ * @brief 各符号的FIRST集（不含ε，ε由nullable表示），终结符为其自身
+ * @note A -> X1...Xn 中X1...Xi-1均可空时FIRST(A) ⊇ FIRST(Xi)，按此包含关系用digraph一遍求出，
+ *       同一强连通分量内的非终结符共享结果，不再整体反复迭代
+ */
+std::vector<TermSet> computeFirstSets(
+    const SymbolTable & symtab,
+    const std::unordered_map<ProductionId, Production> & Productions,
+    const TerminalBits & bits,
+    const std::vector<char> & nullable)
+{
+    const size_t symbolCount = symtab.symbols().size();
+    std::vector<TermSet> first(symbolCount, TermSet(bits.words, 0));
+    for (size_t i = 0; i < bits.termOf.size(); ++i) {
+        setBit(first[bits.termOf[i]], i);
     }
-    return result;
+    std::vector<std::vector<size_t>> includes(symbolCount);
+    for (const auto & [pid, prod] : Productions) {
+        for (SymbolId x : prod.rhs()) {
+            includes[prod.lhs()].push_back(x);
+            if (!nullable[x]) break;
+        }
+    }
+    Digraph(includes, first).run();
+    return first;
 }
 
-std::unordered_map<NonTerminalId, std::unordered_set<std::u8string>> computeFollow(
-    const SymbolTable& symtab,
-    const std::unordered_map<ProductionId, Production>& Productions,
-    const std::unordered_map<NonTerminalId, std::unordered_set<std::u8string>>& FIRST,
+/**
+ * @brief 非终结符的FOLLOW集，按SymbolId
+ * @note A -> αBβ 中FOLLOW(B) ⊇ FIRST(β)，从右向左扫描一遍得到；β可空时FOLLOW(B) ⊇ FOLLOW(A)，同样交给digraph
+ */
+std::vector<TermSet> computeFollowSets(
+    const SymbolTable & symtab,
+    const std::unordered_map<ProductionId, Production> & Productions,
+    const TerminalBits & bits,
+    const std::vector<char> & nullable,
+    const std::vector<TermSet> & first,
     NonTerminalId startSymbol)
 {
-    std::unordered_map<NonTerminalId, std::unordered_set<std::u8string>> FOLLOW;
-    const std::u8string endmarker = u8"$";
-    
-    // 初始化
+    const size_t symbolCount = symtab.symbols().size();
+    std::vector<TermSet> follow(symbolCount, TermSet(bits.words, 0));
+    setBit(follow[startSymbol], bits.bitOf[symtab.find_index(u8"$").value()]);
+    std::vector<std::vector<size_t>> includes(symbolCount);
+    for (const auto & [pid, prod] : Productions) {
+        const auto & rhs = prod.rhs();
+        TermSet firstOfTail(bits.words, 0);
+        bool tailNullable = true;
+        for (size_t i = rhs.size(); i-- > 0; ) {
+            const SymbolId x = rhs[i];
+            if (!symtab[x].is_terminal()) {
+                unionInto(follow[x], firstOfTail);
+                if (tailNullable) includes[x].push_back(prod.lhs());
+            }
+            if (nullable[x]) {
+                unionInto(firstOfTail, first[x]);
+            } else {
+                firstOfTail = first[x];
+                tailNullable = false;
+            }
+        }
+    }
+    Digraph(includes, follow).run();
+    return follow;
+}
+
+/**
+ * @brief FOLLOW位集转为SymbolId列表，作为SLR(1)的向前看符号，终结符按SymbolId升序
+ */
+std::unordered_map<NonTerminalId, std::vector<SymbolId>> followLookaheads(
+    const SymbolTable & symtab,
+    const TerminalBits & bits,
+    const std::vector<TermSet> & follow)
+{
+    std::unordered_map<NonTerminalId, std::vector<SymbolId>> ret;
     for (auto ntid : symtab.nonTerminals()) {
-        FOLLOW[ntid] = {};
+        ret[ntid] = bits.toSymbols(follow[ntid]);
     }
-    FOLLOW[startSymbol].insert(endmarker);
+    return ret;
+}
 
-    bool changed;
-    size_t loop_count = 0;
-    
-    do {
-        changed = false;
-        for (const auto& [_, Prod] : Productions) {
-            auto A = NonTerminalId(Prod.lhs());
-            const auto& rhs = Prod.rhs();
-            
-            for (size_t i = 0; i < rhs.size(); ++i) {
-                if (!symtab[rhs[i]].is_terminal()) {
-                    auto B = NonTerminalId(rhs[i]);
-                    auto beta = std::vector(rhs.begin() + i + 1, rhs.end());
-                    std::vector<SymbolId> beta2;
-                    beta2.reserve(beta.size()); 
-                    for(auto id_ : beta) {
-                        beta2.push_back(SymbolId(id_));
-                    }
-                    auto firstBeta = computeFirstOfSequence(symtab, FIRST, beta2);
-                    
-                    // 规则1
-                    for (auto b : firstBeta) {
-                        if (b != epsilon && FOLLOW[B].insert(b).second) {
-                            changed = true;
-                        }
-                    }
-                    
-                    // 规则2
-                    if (firstBeta.count(epsilon) || beta.empty()) {
-                        for (auto f : FOLLOW[A]) {
-                            if (FOLLOW[B].insert(f).second) {
-                                changed = true;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        
-        if (++loop_count > 50) {
-            std::cerr << "FOLLOW computation failed to converge\n";
-            std::unreachable();
+} // namespace
+
+/**
+ * @brief 产生式下标：按id平铺，并按左部非终结符分组
+ * @note 组内顺序即Productions的遍历顺序，闭包中项目的先后与逐个扫描Productions时一致
+ */
+struct ProductionIndex {
+    std::vector<const Production *> byId;
+    std::vector<std::vector<ProductionId>> byLhs;   //按SymbolId
+    size_t symbolCount = 0;
+};
+
+ProductionIndex buildProductionIndex(const std::unordered_map<ProductionId,Production> & Productions) {
+    ProductionIndex index;
+    size_t prodCount = 0;
+    for(const auto & [pid,prod] : Productions) {
+        prodCount = std::max<size_t>(prodCount,pid + 1);
+        index.symbolCount = std::max<size_t>(index.symbolCount,prod.lhs() + 1);
+        for(auto sym : prod.rhs()) {
+            index.symbolCount = std::max<size_t>(index.symbolCount,sym + 1);
         }
-    } while (changed);
-    
-    return FOLLOW;
+    }
+    index.byId.assign(prodCount,nullptr);
+    index.byLhs.resize(index.symbolCount);
+    for(const auto & [pid,prod] : Productions) {
+        index.byId[pid] = &prod;
+        index.byLhs[prod.lhs()].push_back(pid);
+    }
+    return index;
 }
 
 /**
  * @brief 原地构造闭包
+ * @param mark 按产生式id记录点在最左的项目是否已在state中，值等于epoch即已加入，换状态时只需递增epoch
  * @attention 对于epsilon产生式，其prod的rhs size 为 0
  */
-void generateClosure(const SymbolTable & symtab,const std::unordered_map<ProductionId,Production> & Productions , std::vector<dotProdc> & state) {
-    auto inState = [&state](const dotProdc & i) -> bool {
-        for(auto & p : state ) {
-            if(p.dot_pos == i.dot_pos && p.producId == i.producId) {
-                return true;
-            }
-        }
-        return false;
-    };
+void generateClosure(const SymbolTable & symtab, const ProductionIndex & index, std::vector<dotProdc> & state,
+                     std::vector<uint32_t> & mark, uint32_t epoch) {
+    for(const auto & item : state) {
+        if(item.dot_pos == 0) mark[item.producId] = epoch;
+    }
     for(size_t i = 0 ; i < state.size() ; i++) {
-        auto prod_it = Productions.find(state[i].producId);
-        if(prod_it == Productions.end()) {
+        const Production * prod = index.byId.at(state[i].producId);
+        if(!prod) {
             std::cerr<<"ERROR PRODID FROM CLOSURE";
             std::unreachable();
         }
-        const auto & prod = (*prod_it).second;
-        if(prod.rhs().size() < state[i].dot_pos) {
+        if(prod->rhs().size() < state[i].dot_pos) {
             std::cerr<<"ERROR DOT POS";
             std::unreachable();
         }
-        if(prod.rhs().size() == state[i].dot_pos) {
+        if(prod->rhs().size() == state[i].dot_pos) {
             //到达末尾，不增加闭包
             //含epsilon产生式
             continue;
         }
-        const auto & sym = symtab[prod.rhs()[state[i].dot_pos]];
-        if( sym.is_terminal()) {
+        SymbolId next = prod->rhs()[state[i].dot_pos];
+        if(symtab[next].is_terminal()) {
             continue;
         }
-        else {
-            for(const auto & [pid,prodo] : Productions ) {
-                dotProdc dpi = {0,pid};
-                if(prodo.lhs() != prod.rhs()[state[i].dot_pos] ) continue;
-                if(!inState(dpi)) {
-                    state.push_back(dpi);
-                }
+        for(ProductionId pid : index.byLhs[next]) {
+            if(mark[pid] != epoch) {
+                mark[pid] = epoch;
+                state.push_back(dotProdc{0,pid});
             }
         }
     }
 }
 
 /**
- * @brief 新状态生成
- * @param symtab,Productions 符号表 产生式表
- * @param curr_state 当前状态
- * @param symbolId 符号id（包含终结符与非终结符）
+ * @brief 项目集的规范键：核心项目按(产生式,点位置)排序后打包
+ * @note 闭包由核心唯一确定，核心相同即状态相同
  */
-std::vector<dotProdc> generateState(const SymbolTable & symtab ,const std::unordered_map<ProductionId,Production> & Productions,const std::vector<dotProdc> &curr_state, const SymbolIdType auto symbolId) {
-    std::vector<dotProdc> newState;
-    for (auto & item : curr_state) {
-        auto prod_it = Productions.find(item.producId);
-        const auto & prod = (*prod_it).second;
-        if(prod.rhs().size() == item.dot_pos) continue;
-        if(prod.rhs()[item.dot_pos] != symbolId) continue;
-        newState.emplace_back(dotProdc{ item.dot_pos + 1 , prod.index() });
-    }
-    generateClosure(symtab,Productions,newState);
-
-    return newState;
+struct KernelHash {
+    size_t operator()(const std::vector<uint64_t> & kernel) const {
+        uint64_t h = kernel.size();
+        for(uint64_t item : kernel) {
+            h ^= (item * 0x9e3779b97f4a7c15ull) + (h << 6) + (h >> 2);
+        }
+        return static_cast<size_t>(h);
+    }
+};
+
+std::vector<uint64_t> kernelKey(const std::vector<dotProdc> & kernel) {
+    std::vector<uint64_t> key;
+    key.reserve(kernel.size());
+    for(const auto & item : kernel) {
+        key.push_back((static_cast<uint64_t>(item.producId) << 32) | item.dot_pos);
+    }
+    std::sort(key.begin(),key.end());
+    return key;
 }
 
 /**
- * @brief 检查新状态是否已存在于状态集合中（使用简单易用的朴素查重算法，O(n3)复杂度）
- * @param states 现有的所有状态集合
- * @param newState 待检查的新状态
- * @return 若存在则返回对应状态的ID，否则返回-1
+ * @brief 构造LR(0)项目集规范族及GOTO表
+ * @note 新项目集先按核心查哈希表，已存在时不再求闭包；
+ *       各状态的出边符号仍按unordered_set的遍历顺序处理，状态编号与逐一比对的旧实现一致
  */
-std::optional<StateId> findExistingState(
-    const std::vector<std::vector<dotProdc>>& states,
-    const std::vector<dotProdc>& newState) 
+void buildLR0Automaton(
+    const SymbolTable & symtab,
+    const std::unordered_map<ProductionId,Production> & Productions,
+    ProductionId startProd,
+    std::vector<std::vector<dotProdc>> & states,
+    std::vector<std::unordered_map<SymbolId, StateId>> & gotoTable)
 {
-    if (newState.empty()) return std::nullopt;
-
-    // 第一层遍历：所有现有状态
-    for (int existingId = 0; existingId < states.size(); ++existingId) {
-        const auto& existingState = states[existingId];
-        // 快速检查：状态大小不同则直接跳过
-        if (existingState.size() != newState.size()) continue;
-        bool isSame = true;
-        // 第二层遍历：比较每个dotProdc项
-        for (const auto& newItem : newState) {
-            bool foundItem = false;
-            // 第三层遍历：在现有状态中查找匹配项
-            for (const auto& existingItem : existingState) {
-                if (existingItem.producId == newItem.producId && 
-                    existingItem.dot_pos == newItem.dot_pos) {
-                    foundItem = true;
-                    break;
-                }
-            }
-            if (!foundItem) {
-                isSame = false;
-                break;
+    const auto index = buildProductionIndex(Productions);
+    std::vector<uint32_t> mark(index.byId.size(),0);
+    uint32_t epoch = 0;
+    std::unordered_map<std::vector<uint64_t>,StateId,KernelHash> kernelId;
+
+    std::vector<dotProdc> start = {{0,startProd}};
+    kernelId.emplace(kernelKey(start),StateId(0));
+    generateClosure(symtab,index,start,mark,++epoch);
+    states.push_back(std::move(start));
+    gotoTable.emplace_back();
+
+    //按出边符号分组的核心，下标为SymbolId，处理完一个状态后清空用过的组
+    std::vector<std::vector<dotProdc>> kernelOf(index.symbolCount);
+    for(size_t i = 0 ; i < states.size() ; i++) {
+        std::unordered_set<SymbolId> symclosure;
+        for(const auto & item : states[i]) {
+            const auto & rhs = index.byId[item.producId]->rhs();
+            if(item.dot_pos < rhs.size()) {
+                symclosure.insert(rhs[item.dot_pos]);
+                kernelOf[rhs[item.dot_pos]].push_back(dotProdc{item.dot_pos + 1,item.producId});
             }
         }
-        
-        if (isSame) {
-            return StateId(existingId); // 找到完全相同的状态
+        for(auto symid : symclosure) {
+            auto & kernel = kernelOf[symid];
+            auto [it,inserted] = kernelId.try_emplace(kernelKey(kernel),StateId(states.size()));
+            if(inserted) {
+                std::vector<dotProdc> newState = std::move(kernel);
+                generateClosure(symtab,index,newState,mark,++epoch);
+                states.push_back(std::move(newState));
+                gotoTable.emplace_back();
+            }
+            gotoTable.at(i)[symid] = it->second;
+            kernel.clear();
         }
     }
-    
-    return std::nullopt; // 未找到重复状态
 }
 
-// 修改后的状态生成逻辑，同时处理GOTO
-void processNewStateGOTO(
-    std::vector<std::vector<dotProdc>>& states,
-    std::vector<std::unordered_map<SymbolId, StateId>>& gotoTable,
-    const SymbolTable& symtab,
-    const std::unordered_map<ProductionId, Production>& Productions,
-    const std::vector<dotProdc>& newState,
-    const StateId curr_stateId,
-    const SymbolId curr_symId) 
+namespace {
+
+/**
+ * @brief 按核心分片加锁的哈希表，同一波次中各线程并发登记新项目集
+ * @note 首个登记某核心的线程负责求闭包，编号留到波次结束后统一分配
+ */
+class ConcurrentKernelMap {
+public:
+    struct Entry {
+        std::vector<uint64_t> key;
+        std::vector<dotProdc> items;
+        std::optional<StateId> id;  //波次结束后分配
+    };
+
+    /**
+     * @return 条目及是否由本次调用新建
+     */
+    std::pair<Entry *, bool> intern(std::vector<uint64_t> && key) {
+        Shard & shard = shards_[KernelHash{}(key) % shardCount];
+        std::lock_guard lock(shard.mutex);
+        auto [it,inserted] = shard.map.try_emplace(key);
+        if(inserted) {
+            it->second = std::make_unique<Entry>();
+            it->second->key = std::move(key);
+        }
+        return {it->second.get(),inserted};
+    }
+    void clear() {
+        for(auto & shard : shards_) shard.map.clear();
+    }
+
+private:
+    static constexpr size_t shardCount = 64;
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::vector<uint64_t>,std::unique_ptr<Entry>,KernelHash> map;
+    };
+    std::array<Shard,shardCount> shards_;
+};
+
+} // namespace
+
+/**
+ * @brief 并行构造LR(0)项目集规范族及GOTO表，结果与buildLR0Automaton逐项相同
+ * @note 按波次展开：第k波为第k-1波新产生的状态。波内各线程只读全局核心表，
+ *       新核心登记到ConcurrentKernelMap并求闭包；波次结束后按(源状态,出边符号顺序)依次分配编号，
+ *       与串行实现首次遇到即编号的顺序一致
+ * @param threadCount 为0时取硬件线程数，波内状态较少时在调用线程上完成
+ */
+void buildLR0AutomatonParallel(
+    const SymbolTable & symtab,
+    const std::unordered_map<ProductionId,Production> & Productions,
+    ProductionId startProd,
+    std::vector<std::vector<dotProdc>> & states,
+    std::vector<std::unordered_map<SymbolId, StateId>> & gotoTable,
+    size_t threadCount)
 {
-    // 先查重
-    auto existingId = findExistingState(states, newState);
-
-    if (!existingId) {
-        // 新状态处理
-        StateId newId = StateId(states.size());
-        states.push_back(newState);
-        // 初始化对应的action和goto表项
+    constexpr size_t minWavePerThread = 32;
+    constexpr size_t chunk = 8;
+    if(threadCount == 0) {
+        threadCount = std::max<size_t>(1,std::thread::hardware_concurrency());
+    }
+    const auto index = buildProductionIndex(Productions);
+    std::unordered_map<std::vector<uint64_t>,StateId,KernelHash> kernelId;
+    {
+        std::vector<uint32_t> mark(index.byId.size(),0);
+        std::vector<dotProdc> start = {{0,startProd}};
+        kernelId.emplace(kernelKey(start),StateId(0));
+        generateClosure(symtab,index,start,mark,1);
+        states.push_back(std::move(start));
         gotoTable.emplace_back();
-        gotoTable.at(curr_stateId)[curr_symId] = newId;
-    } else {
-        gotoTable.at(curr_stateId)[curr_symId] = existingId.value();
+    }
+
+    //出边：已有状态记编号，本波新核心记条目
+    struct Edge {
+        SymbolId sym;
+        StateId known;
+        ConcurrentKernelMap::Entry * fresh;
+    };
+    ConcurrentKernelMap waveKernels;
+    std::vector<std::vector<Edge>> edges;
+    for(size_t lo = 0 ; lo < states.size() ; ) {
+        const size_t hi = states.size();
+        edges.assign(hi - lo,{});
+        std::atomic<size_t> next = lo;
+        auto expand = [&]() {
+            std::vector<std::vector<dotProdc>> kernelOf(index.symbolCount);
+            std::vector<uint32_t> mark(index.byId.size(),0);
+            uint32_t epoch = 0;
+            size_t begin;
+            while((begin = next.fetch_add(chunk)) < hi) {
+                for(size_t i = begin ; i < std::min(begin + chunk,hi) ; i++) {
+                    std::unordered_set<SymbolId> symclosure;
+                    for(const auto & item : states[i]) {
+                        const auto & rhs = index.byId[item.producId]->rhs();
+                        if(item.dot_pos < rhs.size()) {
+                            symclosure.insert(rhs[item.dot_pos]);
+                            kernelOf[rhs[item.dot_pos]].push_back(dotProdc{item.dot_pos + 1,item.producId});
+                        }
+                    }
+                    auto & out = edges[i - lo];
+                    for(auto symid : symclosure) {
+                        auto & kernel = kernelOf[symid];
+                        auto key = kernelKey(kernel);
+                        if(auto it = kernelId.find(key) ; it != kernelId.end()) {
+                            out.push_back(Edge{symid,it->second,nullptr});
+                        }
+                        else {
+                            auto [entry,inserted] = waveKernels.intern(std::move(key));
+                            if(inserted) {
+                                entry->items = std::move(kernel);
+                                generateClosure(symtab,index,entry->items,mark,++epoch);
+                            }
+                            out.push_back(Edge{symid,StateId(0),entry});
+                        }
+                        kernel.clear();
+                    }
+                }
+            }
+        };
+        const size_t workers = std::min(threadCount,(hi - lo) / minWavePerThread);
+        if(workers <= 1) {
+            expand();
+        }
+        else {
+            std::vector<std::jthread> pool;
+            for(size_t t = 1 ; t < workers ; t++) pool.emplace_back(expand);
+            expand();
+        }
+
+        //按源状态与出边顺序分配编号
+        for(size_t i = lo ; i < hi ; i++) {
+            for(const Edge & e : edges[i - lo]) {
+                if(e.fresh && !e.fresh->id) {
+                    e.fresh->id = StateId(states.size());
+                    kernelId.emplace(std::move(e.fresh->key),e.fresh->id.value());
+                    states.push_back(std::move(e.fresh->items));
+                    gotoTable.emplace_back();
+                }
+                gotoTable.at(i)[e.sym] = e.fresh ? e.fresh->id.value() : e.known;
+            }
+        }
+        waveKernels.clear();
+        lo = hi;
     }
 }
 
@@ -320,10 +516,40 @@ enum ConflictType {
     REDUCE_REDUCE
 };
 
+/**
+ * @brief 分析表统计，用于比较SLR(1)与LALR(1)
+ */
+struct TableStats {
+    int conflicts = 0;          //出现过的冲突，含已消解的
+    int unresolved = 0;
+    int forcedReduce = 0;       //按冲突消解文件改为归约的次数
+    int precedence = 0;         //按优先级与结合性消解的次数
+    size_t reduceEntries = 0;   //ACTION表中的归约项（不含接受）
+};
+
+/**
+ * @brief 归约项目[A -> ω·]在某状态下的向前看终结符
+ */
+using LookaheadFn = std::function<const std::vector<SymbolId> & (StateId, const Production &)>;
+
+/**
+ * @brief 产生式的优先级取右部最后一个终结符的优先级（yacc规则），该终结符未声明时没有优先级
+ */
+std::optional<Precedence> productionPrecedence(const Production & prod, const SymbolTable & symtab, const PrecedenceTable & precedence) {
+    for (auto it = prod.rhs().rbegin(); it != prod.rhs().rend(); ++it) {
+        if (!symtab[*it].is_terminal()) continue;
+        auto p = precedence.find(*it);
+        if (p == precedence.end()) return std::nullopt;
+        return p->second;
+    }
+    return std::nullopt;
+}
+
 /**
  * @brief SLR(1)冲突消解策略
  * @return bool 是否成功消解冲突
- * @note SLR(1)只能处理移进-规约冲突(优先移进)
+ * @note SLR(1)只能处理移进-规约冲突：产生式与向前看终结符都声明了优先级时按优先级与结合性，
+ *       否则按冲突消解文件，仍未匹配则优先移进；%nonassoc同级时记入nonassoc，由调用方置为出错
  */
 bool resolveSLRConflict(
     const std::vector<std::vector<dotProdc>>& states,
@@ -331,11 +557,15 @@ bool resolveSLRConflict(
     const SymbolTable& symtab,
     const std::unordered_map<ProductionId, Production>& Productions,
     const std::vector<ForceReducedProd> & forceReduceProd,
+    const PrecedenceTable & precedence,
+    std::vector<std::pair<StateId, SymbolId>> & nonassoc,
     StateId state,
     SymbolId symbolid,
     action exist,
     action new_action,
-    ConflictType conflict_type) {
+    ConflictType conflict_type,
+    TableStats & stats,
+    bool verbose) {
     // SLR只能处理移进-规约冲突(优先移进)
 
     auto visitor = overload {
@@ -356,6 +586,22 @@ bool resolveSLRConflict(
         else {
             std::unreachable();
         }
+        auto prodPrec = productionPrecedence(Productions.at(checkId),symtab,precedence);
+        auto symPrec = precedence.find(symbolid);
+        if (prodPrec && symPrec != precedence.end()) {
+            stats.precedence++;
+            const int prodLevel = prodPrec->level;
+            const int symLevel = symPrec->second.level;
+            if (prodLevel == symLevel && symPrec->second.assoc == Assoc::NonAssoc) {
+                if(verbose) std::cerr << "优先级消解: 不可结合，置为出错" << std::endl;
+                nonassoc.emplace_back(state,symbolid);
+                return true;
+            }
+            const bool reduce = prodLevel > symLevel || (prodLevel == symLevel && symPrec->second.assoc == Assoc::Left);
+            if(verbose) std::cerr << (reduce ? "优先级消解: 选择归约" : "优先级消解: 选择移进") << std::endl;
+            actionTable[state][symbolid] = reduce ? action(checkId) : (existing_is_shift ? exist : new_action);
+            return true;
+        }
         bool match = false;
         for(const auto & rule : forceReduceProd) {
             if(equals(rule.strProd,Productions.at(checkId),symtab)) {
@@ -365,30 +611,33 @@ bool resolveSLRConflict(
                 }
             }
         }
+        if(match) {
+            stats.forcedReduce++;
+        }
         if(existing_is_shift) {
             if(match) {
-                std::cerr << "匹配特殊SLR冲突消解规则: 选择归约优先" <<std::endl;
+                if(verbose) std::cerr << "匹配特殊SLR冲突消解规则: 选择归约优先" <<std::endl;
                 actionTable[state][symbolid] = std::get<ProductionId>(new_action); //多次一举，方便debug
                 return true;
             }
             // 现有是移进，保持不变
-            std::cerr << "SLR冲突消解: 选择移进优先" << std::endl;
+            if(verbose) std::cerr << "SLR冲突消解: 选择移进优先" << std::endl;
             return true;
         }
         else if(new_is_shift) {
             if(match) {
-                std::cerr << "匹配特殊SLR冲突消解规则: 选择归约优先" <<std::endl;
+                if(verbose) std::cerr << "匹配特殊SLR冲突消解规则: 选择归约优先" <<std::endl;
                 //保持不变
                 return true;
             }
             // 新动作是移进，覆盖现有规约
             actionTable[state][symbolid] = new_action;
-            std::cerr << "SLR冲突消解: 选择移进优先" << std::endl;
+            if(verbose) std::cerr << "SLR冲突消解: 选择移进优先" << std::endl;
             return true;
         }
     }
     else {
-        std::cerr << "归约-归约冲突，未定义消解方案" << std::endl;
+        if(verbose) std::cerr << "归约-归约冲突，未定义消解方案" << std::endl;
     }
     return false;
 }
@@ -504,22 +753,391 @@ ConflictType checkActionConflict(action exist , action new_action) {
 }
 
 /**
- * @brief 生成SLR(1)分析表
- * @return int 不可消解冲突数量
+ * @brief LALR(1)向前看符号（DeRemer & Pennello 1982），在同一组LR(0)状态上计算
+ * @note DR/reads得Read集，includes得Follow集，再沿lookback汇总到归约项目；
+ *       返回值按状态、产生式索引，终结符按SymbolId升序
  */
-int generateSLRTable(
+std::vector<std::unordered_map<ProductionId, std::vector<SymbolId>>> computeLALRLookaheads(
+    const SymbolTable & symtab,
+    const std::unordered_map<ProductionId, Production> & Productions,
+    const std::vector<std::vector<dotProdc>> & states,
+    const std::vector<std::unordered_map<SymbolId, StateId>> & gotoTable,
+    const NonTerminalId startId)
+{
+    const auto index = buildProductionIndex(Productions);
+    const TerminalBits bits(symtab);
+    const auto & termBit = bits.bitOf;
+    const size_t words = bits.words;
+    const size_t endBit = termBit[symtab.find_index(u8"$").value()];
+    const auto nullable = computeNullable(symtab.symbols().size(), Productions);
+
+    //非终结符转移(p,A)编号
+    std::vector<std::pair<StateId, SymbolId>> trans;
+    std::unordered_map<uint64_t, size_t> transId;
+    auto key = [](size_t p, size_t x) { return (static_cast<uint64_t>(p) << 32) | x; };
+    for (size_t p = 0; p < gotoTable.size(); ++p) {
+        for (const auto & [sym, q] : gotoTable[p]) {
+            if (!symtab[sym].is_terminal()) {
+                transId.emplace(key(p, sym), trans.size());
+                trans.emplace_back(StateId(p), sym);
+            }
+        }
+    }
+
+    //DR与reads
+    std::vector<TermSet> F(trans.size(), TermSet(words, 0));
+    std::vector<std::vector<size_t>> reads(trans.size());
+    for (size_t t = 0; t < trans.size(); ++t) {
+        const StateId r = gotoTable[trans[t].first].at(trans[t].second);
+        for (const auto & [sym, q] : gotoTable[r]) {
+            if (symtab[sym].is_terminal()) {
+                setBit(F[t], termBit[sym]);
+            } else if (nullable[sym]) {
+                reads[t].push_back(transId.at(key(r, sym)));
+            }
+        }
+        //增广产生式START -> S·只在$上接受，相当于其后跟随$
+        for (const auto & item : states[r]) {
+            const Production & prod = *index.byId[item.producId];
+            if (prod.lhs() == startId && item.dot_pos == prod.rhs().size()) setBit(F[t], endBit);
+        }
+    }
+    Digraph(reads, F).run();
+
+    //includes与lookback
+    std::vector<std::vector<size_t>> includes(trans.size());
+    std::unordered_map<uint64_t, std::vector<size_t>> lookback;
+    for (size_t t = 0; t < trans.size(); ++t) {
+        for (ProductionId pid : index.byLhs[trans[t].second]) {
+            const auto & rhs = index.byId[pid]->rhs();
+            StateId q = trans[t].first;
+            for (size_t i = 0; i < rhs.size(); ++i) {
+                if (!symtab[rhs[i]].is_terminal()) {
+                    bool restNullable = std::all_of(rhs.begin() + i + 1, rhs.end(), [&](SymbolId x) { return nullable[x] != 0; });
+                    if (restNullable) includes[transId.at(key(q, rhs[i]))].push_back(t);
+                }
+                q = gotoTable[q].at(rhs[i]);
+            }
+            lookback[key(q, pid)].push_back(t);
+        }
+    }
+    Digraph(includes, F).run();
+
+    std::vector<std::unordered_map<ProductionId, std::vector<SymbolId>>> LA(states.size());
+    for (size_t q = 0; q < states.size(); ++q) {
+        for (const auto & item : states[q]) {
+            const Production & prod = *index.byId[item.producId];
+            if (item.dot_pos != prod.rhs().size() || prod.lhs() == startId) continue;
+            TermSet la(words, 0);
+            auto it = lookback.find(key(q, item.producId));
+            if (it != lookback.end()) {
+                for (size_t t : it->second) unionInto(la, F[t]);
+            }
+            LA[q][item.producId] = bits.toSymbols(la);
+        }
+    }
+    return LA;
+}
+
+namespace {
+
+/**
+ * @brief LR(1)状态的核心：项目按(产生式,点位置)打包键排序，向前看集合与之一一对应
+ */
+struct LR1Kernel {
+    std::vector<uint64_t> core;
+    std::vector<TermSet> la;
+};
+
+struct LR1Item {
+    ProductionId prod;
+    size_t dot;
+    TermSet la;
+};
+
+/**
+ * @brief 同核心的两组向前看集合是否弱相容（Pager 1977）
+ * @note 对任意i≠j，交叉的交集为空，或任一方自身的第i、j项已相交；
+ *       弱相容的状态合并后不会出现规范LR(1)中没有的归约-归约冲突
+ */
+bool weaklyCompatible(const std::vector<TermSet> & a, const std::vector<TermSet> & b) {
+    for (size_t i = 0; i < a.size(); ++i) {
+        for (size_t j = i + 1; j < a.size(); ++j) {
+            if (!intersects(a[i], b[j]) && !intersects(a[j], b[i])) continue;
+            if (intersects(a[i], a[j]) || intersects(b[i], b[j])) continue;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief LR(1)闭包与后继核心的计算，按状态反复调用时复用标记数组
+ */
+class LR1Closure {
+public:
+    LR1Closure(const SymbolTable & symtab, const std::unordered_map<ProductionId, Production> & Productions)
+        : symtab(symtab), index(buildProductionIndex(Productions)), bits(symtab),
+          nullable(computeNullable(symtab.symbols().size(), Productions)),
+          first(computeFirstSets(symtab, Productions, bits, nullable)),
+          slot(index.byId.size(), 0), slotEpoch(index.byId.size(), 0),
+          groupOf(index.symbolCount, 0), groupEpoch(index.symbolCount, 0)
+    {
+    }
+
+    const TerminalBits & terminals() const { return bits; }
+    const ProductionIndex & productions() const { return index; }
+
+    /**
+     * @brief 由核心求闭包，项目顺序为核心在前，其后按加入顺序
+     */
+    void closure(const LR1Kernel & kernel, std::vector<LR1Item> & items) {
+        ++epoch;
+        items.clear();
+        std::vector<size_t> work;
+        for (size_t i = 0; i < kernel.core.size(); ++i) {
+            ProductionId pid = ProductionId(kernel.core[i] >> 32);
+            size_t dot = kernel.core[i] & 0xffffffffu;
+            if (dot == 0) {
+                slot[pid] = items.size();
+                slotEpoch[pid] = epoch;
+            }
+            items.push_back(LR1Item{pid, dot, kernel.la[i]});
+            work.push_back(i);
+        }
+        std::vector<char> queued(items.size(), 1);
+        while (!work.empty()) {
+            size_t i = work.back();
+            work.pop_back();
+            queued[i] = 0;
+            const auto & rhs = index.byId[items[i].prod]->rhs();
+            if (items[i].dot >= rhs.size() || symtab[rhs[items[i].dot]].is_terminal()) continue;
+            //[A -> α·Bβ, L] 为B的产生式带来 FIRST(β) ∪ (β可空 ? L : ∅)
+            TermSet add(bits.words, 0);
+            size_t k = items[i].dot + 1;
+            for (; k < rhs.size(); ++k) {
+                unionInto(add, first[rhs[k]]);
+                if (!nullable[rhs[k]]) break;
+            }
+            if (k == rhs.size()) unionInto(add, items[i].la);
+            for (ProductionId pid : index.byLhs[rhs[items[i].dot]]) {
+                if (slotEpoch[pid] != epoch) {
+                    slotEpoch[pid] = epoch;
+                    slot[pid] = items.size();
+                    items.push_back(LR1Item{pid, 0, add});
+                    queued.push_back(1);
+                    work.push_back(items.size() - 1);
+                }
+                else if (unionInto(items[slot[pid]].la, add) && !queued[slot[pid]]) {
+                    queued[slot[pid]] = 1;
+                    work.push_back(slot[pid]);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 按出边符号分组得到后继核心，符号按在闭包中首次出现的顺序
+     */
+    void successors(const std::vector<LR1Item> & items, std::vector<std::pair<SymbolId, LR1Kernel>> & out) {
+        ++epoch;
+        out.clear();
+        std::vector<std::vector<std::pair<uint64_t, const TermSet *>>> groups;
+        for (const auto & item : items) {
+            const auto & rhs = index.byId[item.prod]->rhs();
+            if (item.dot >= rhs.size()) continue;
+            SymbolId x = rhs[item.dot];
+            if (groupEpoch[x] != epoch) {
+                groupEpoch[x] = epoch;
+                groupOf[x] = groups.size();
+                groups.emplace_back();
+                out.emplace_back(x, LR1Kernel{});
+            }
+            groups[groupOf[x]].emplace_back((static_cast<uint64_t>(item.prod) << 32) | (item.dot + 1), &item.la);
+        }
+        for (size_t g = 0; g < groups.size(); ++g) {
+            auto & group = groups[g];
+            std::sort(group.begin(), group.end(), [](const auto & a, const auto & b) { return a.first < b.first; });
+            auto & kernel = out[g].second;
+            for (const auto & [key, la] : group) {
+                kernel.core.push_back(key);
+                kernel.la.push_back(*la);
+            }
+        }
+    }
+
+private:
+    const SymbolTable & symtab;
+    const ProductionIndex index;
+    const TerminalBits bits;
+    const std::vector<char> nullable;
+    const std::vector<TermSet> first;
+    std::vector<size_t> slot;
+    std::vector<uint32_t> slotEpoch;
+    std::vector<size_t> groupOf;
+    std::vector<uint32_t> groupEpoch;
+    uint32_t epoch = 0;
+};
+
+} // namespace
+
+/**
+ * @brief 构造LR(1)项目集族，同核心且弱相容的状态合并（Pager的PGM算法）
+ * @param merge 为false时只合并向前看完全相同的状态，即规范LR(1)
+ * @note 合并使某状态的向前看变大时重新计算其后继；构造结束后去掉不可达状态，按广度优先重新编号，
+ *       并在最终的转移图上重新传播一遍向前看，去除已失效路径留下的多余符号
+ * @return 按状态、产生式索引的归约项目向前看符号，终结符按SymbolId升序
+ */
+std::vector<std::unordered_map<ProductionId, std::vector<SymbolId>>> buildLR1Automaton(
+    const SymbolTable & symtab,
+    const std::unordered_map<ProductionId, Production> & Productions,
+    ProductionId startProd,
+    bool merge,
+    std::vector<std::vector<dotProdc>> & states,
+    std::vector<std::unordered_map<SymbolId, StateId>> & gotoTable)
+{
+    LR1Closure ctx(symtab, Productions);
+    const TerminalBits & bits = ctx.terminals();
+
+    std::vector<LR1Kernel> kernels;
+    std::vector<std::vector<std::pair<SymbolId, size_t>>> edges;
+    std::unordered_map<std::vector<uint64_t>, std::vector<size_t>, KernelHash> byCore;
+    std::vector<char> queued;
+    std::deque<size_t> work;
+
+    LR1Kernel start{{static_cast<uint64_t>(startProd) << 32}, {TermSet(bits.words, 0)}};
+    setBit(start.la[0], bits.bitOf[symtab.find_index(u8"$").value()]);
+    byCore[start.core].push_back(0);
+    kernels.push_back(std::move(start));
+    edges.emplace_back();
+    queued.push_back(1);
+    work.push_back(0);
+
+    std::vector<LR1Item> items;
+    std::vector<std::pair<SymbolId, LR1Kernel>> succ;
+    while (!work.empty()) {
+        size_t s = work.front();
+        work.pop_front();
+        queued[s] = 0;
+        ctx.closure(kernels[s], items);
+        ctx.successors(items, succ);
+        edges[s].clear();
+        for (auto & [x, kernel] : succ) {
+            auto & candidates = byCore[kernel.core];
+            size_t target = kernels.size();
+            for (size_t c : candidates) {
+                if (merge ? weaklyCompatible(kernels[c].la, kernel.la) : kernels[c].la == kernel.la) {
+                    target = c;
+                    break;
+                }
+            }
+            if (target == kernels.size()) {
+                candidates.push_back(target);
+                kernels.push_back(std::move(kernel));
+                edges.emplace_back();
+                queued.push_back(1);
+                work.push_back(target);
+            }
+            else {
+                bool grew = false;
+                for (size_t i = 0; i < kernel.la.size(); ++i) {
+                    grew |= unionInto(kernels[target].la[i], kernel.la[i]);
+                }
+                if (grew && !queued[target]) {
+                    queued[target] = 1;
+                    work.push_back(target);
+                }
+            }
+            edges[s].emplace_back(x, target);
+        }
+    }
+
+    //去掉不可达状态并按广度优先重新编号
+    constexpr size_t unreached = std::numeric_limits<size_t>::max();
+    std::vector<size_t> newId(kernels.size(), unreached);
+    std::vector<size_t> order{0};
+    newId[0] = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (const auto & [x, t] : edges[order[i]]) {
+            if (newId[t] == unreached) {
+                newId[t] = order.size();
+                order.push_back(t);
+            }
+        }
+    }
+
+    //在最终的转移图上重新传播向前看
+    std::vector<LR1Kernel> finalKernels(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        finalKernels[i].core = std::move(kernels[order[i]].core);
+        finalKernels[i].la.assign(finalKernels[i].core.size(), TermSet(bits.words, 0));
+    }
+    finalKernels[0].la[0] = kernels[0].la[0];
+    queued.assign(order.size(), 1);
+    work.assign(order.size(), 0);
+    std::iota(work.begin(), work.end(), size_t(0));
+    while (!work.empty()) {
+        size_t s = work.front();
+        work.pop_front();
+        queued[s] = 0;
+        ctx.closure(finalKernels[s], items);
+        ctx.successors(items, succ);
+        const auto & out = edges[order[s]];
+        for (size_t e = 0; e < succ.size(); ++e) {
+            auto edge = std::find_if(out.begin(), out.end(), [&](const auto & x) { return x.first == succ[e].first; });
+            size_t t = newId[edge->second];
+            assert(finalKernels[t].core == succ[e].second.core);
+            bool grew = false;
+            for (size_t i = 0; i < succ[e].second.la.size(); ++i) {
+                grew |= unionInto(finalKernels[t].la[i], succ[e].second.la[i]);
+            }
+            if (grew && !queued[t]) {
+                queued[t] = 1;
+                work.push_back(t);
+            }
+        }
+    }
+
+    const auto & index = ctx.productions();
+    std::vector<std::unordered_map<ProductionId, std::vector<SymbolId>>> LA(order.size());
+    states.assign(order.size(), {});
+    gotoTable.assign(order.size(), {});
+    for (size_t s = 0; s < order.size(); ++s) {
+        ctx.closure(finalKernels[s], items);
+        for (const auto & item : items) {
+            states[s].push_back(dotProdc{item.dot, item.prod});
+            if (item.dot == index.byId[item.prod]->rhs().size()) {
+                LA[s][item.prod] = bits.toSymbols(item.la);
+            }
+        }
+        for (const auto & [x, t] : edges[order[s]]) {
+            gotoTable[s][x] = StateId(newId[t]);
+        }
+    }
+    return LA;
+}
+
+/**
+ * @brief 在LR(0)状态上生成分析表，归约项目的向前看符号由lookahead给出（SLR(1)取FOLLOW集，LALR(1)取LA集）
+ * @param verbose 为false时不输出冲突详情，仅统计
+ */
+TableStats generateLRTable(
     const std::vector<std::vector<dotProdc>>& states,
     std::vector<std::unordered_map<SymbolId, action>>& actionTable,
     const std::vector<std::unordered_map<SymbolId, StateId>>& gotoTable,
     const SymbolTable& symtab,
     const std::unordered_map<ProductionId, Production>& Productions,
     const std::vector<ForceReducedProd> & forceReduceProd,
-    const std::unordered_map<NonTerminalId, std::unordered_set<std::u8string>> & FOLLOW,
-    const NonTerminalId startId)
+    const PrecedenceTable & precedence,
+    const LookaheadFn & lookahead,
+    const NonTerminalId startId,
+    bool verbose = true)
 {
     assert(states.size() == gotoTable.size() );
     actionTable.resize(states.size());
-    int conflicts_count = 0;
+    TableStats stats;
+    int & conflicts_count = stats.unresolved;
+    std::vector<std::pair<StateId, SymbolId>> nonassoc;
 
     for (StateId state_i(0); state_i < states.size(); state_i=StateId(state_i+1))
     {
@@ -541,22 +1159,19 @@ int generateSLRTable(
                     continue;
                 }
                 // 常规规约
-                for (const auto & follow_sym : FOLLOW.at(prod.lhs())) {
-                    auto symid_ = symtab.find_index(follow_sym);
-                    if(!symid_ || !symtab[symid_.value()].is_terminal()) {
-                        std::cerr<<"FOLLOW集出错";
-                    }
-                    auto termid = TerminalId(symid_.value());
+                for (SymbolId la : lookahead(state_i, prod)) {
+                    auto termid = TerminalId(la);
                     if (actionTable[state_i].count(SymbolId(termid))) {
                         // 检查冲突
                         action new_action = prod.index();
                         ConflictType conflict = checkActionConflict(
                             actionTable[state_i][SymbolId(termid)], new_action);
                         if (conflict != NO_CONFLICT) {
-                            reportConflict(states,actionTable,symtab,Productions,state_i,SymbolId(termid),actionTable[state_i][SymbolId(termid)], new_action,conflict);
+                            if(verbose) reportConflict(states,actionTable,symtab,Productions,state_i,SymbolId(termid),actionTable[state_i][SymbolId(termid)], new_action,conflict);
                             conflicts_count += 1;
+                            stats.conflicts += 1;
                             // 尝试消解冲突
-                            if (!resolveSLRConflict(states,actionTable,symtab,Productions,forceReduceProd,state_i,SymbolId(termid),actionTable[state_i][SymbolId(termid)], new_action,conflict) ){
+                            if (!resolveSLRConflict(states,actionTable,symtab,Productions,forceReduceProd,precedence,nonassoc,state_i,SymbolId(termid),actionTable[state_i][SymbolId(termid)], new_action,conflict,stats,verbose) ){
                                 continue;  // 无法消解，跳过设置
                             } else {
                                 conflicts_count -= 1;
@@ -587,10 +1202,11 @@ int generateSLRTable(
                     ConflictType conflict = checkActionConflict(
                         actionTable[state_i][SymbolId(termid)], new_action);
                     if (conflict != NO_CONFLICT) {
-                        reportConflict(states,actionTable,symtab,Productions,state_i,SymbolId(termid),actionTable[state_i][SymbolId(termid)], new_action,conflict);
+                        if(verbose) reportConflict(states,actionTable,symtab,Productions,state_i,SymbolId(termid),actionTable[state_i][SymbolId(termid)], new_action,conflict);
                         conflicts_count += 1;
+                        stats.conflicts += 1;
                         // 尝试消解冲突
-                        if (!resolveSLRConflict(states,actionTable,symtab,Productions,forceReduceProd,state_i,SymbolId(termid),actionTable[state_i][SymbolId(termid)], new_action,conflict) ){
+                        if (!resolveSLRConflict(states,actionTable,symtab,Productions,forceReduceProd,precedence,nonassoc,state_i,SymbolId(termid),actionTable[state_i][SymbolId(termid)], new_action,conflict,stats,verbose) ){
                             continue;  // 无法消解，跳过设置
                         } else {
                             conflicts_count -= 1;
@@ -607,8 +1223,20 @@ int generateSLRTable(
             }
         }
     }
-    
-    return conflicts_count;
+
+    //不可结合的运算符连用是语法错误，该格此后填入的动作一并去掉
+    for (const auto & [state, sym] : nonassoc) {
+        actionTable[state].erase(sym);
+    }
+
+    for (const auto & row : actionTable) {
+        for (const auto & [sym, act] : row) {
+            if (std::holds_alternative<ProductionId>(act) && Productions.at(std::get<ProductionId>(act)).lhs() != startId) {
+                stats.reduceEntries++;
+            }
+        }
+    }
+    return stats;
 }
 
 
@@ -620,6 +1248,7 @@ void parserGen_test_main() {
     fs::path curr_path = fs::current_path();
     fs::path gpath = curr_path /".."/ u8"grammar" / u8"grammar.txt";
     fs::path tpath = curr_path /".."/ u8"grammar" / u8"terminal.txt";
+    fs::path rpath = curr_path /".."/ u8"grammar" / u8"SLR1ConflictReslove.txt";
 
     std::unordered_map<ProductionId,Production> Productions;
     std::vector<std::vector<dotProdc>> states; 
@@ -628,6 +1257,7 @@ void parserGen_test_main() {
     SymbolTable symtab;
 
     std::vector<Production> mproductions;
+    PrecedenceTable precedence;
     try {
         readTerminals(symtab,tpath);
         readProductionRule(symtab,mproductions,gpath);
@@ -636,6 +1266,8 @@ void parserGen_test_main() {
         std::cerr << "read grammar failed: " ;
         std::cerr << e.what() << '\n';
     }
+    //优先级声明有误时不能继续：冲突会改按默认移进消解，悄悄生成另一张表
+    precedence = readPrecedence(symtab,gpath);
     symtab.add_symbol(u8"START",u8"START",u8"",false);
     symtab.add_symbol(u8"$",u8"END",u8"",true);
     //增广文法
@@ -646,42 +1278,30 @@ void parserGen_test_main() {
         Productions.insert({ProductionId(prod.index()),prod});
     }
 
-    auto FIRST = computeFirst(symtab,Productions);
-    auto FOLLOW = computeFollow(symtab,Productions,FIRST,symtab.nonTerminals().front());
+    const TerminalBits bits(symtab);
+    const auto nullable = computeNullable(symtab.symbols().size(),Productions);
+    const auto first = computeFirstSets(symtab,Productions,bits,nullable);
+    const auto follow = computeFollowSets(symtab,Productions,bits,nullable,first,symtab.nonTerminals().front());
     std::cout<<"print FIRST ----------------- \n";
-    for(auto & [ntid,ntchar] : FIRST) {
+    for(auto ntid : symtab.nonTerminals()) {
         std::cout<<toString(symtab[ntid].sym()) << " ";
-        for(auto & uc : ntchar) {
-            std::cout<<toString(uc)<<" ";
+        for(auto symid : bits.toSymbols(first[ntid])) {
+            std::cout<<toString(symtab[symid].sym())<<" ";
         }
+        if(nullable[ntid]) std::cout<<toString(epsilon)<<" ";
         std::cout<<" "<<std::endl;
     }
     std::cout<<"print FOLLOW ----------------- \n";
-    for(auto & [ntid,ntchar] : FOLLOW) {
+    for(auto ntid : symtab.nonTerminals()) {
         std::cout<<toString(symtab[ntid].sym()) << " ";
-        for(auto & uc : ntchar) {
-            std::cout<<toString(uc)<<" ";
+        for(auto symid : bits.toSymbols(follow[ntid])) {
+            std::cout<<toString(symtab[symid].sym())<<" ";
         }
         std::cout<<" "<<std::endl;
     }
 
     
-    states.emplace_back(std::vector<dotProdc>{{0,pres.index()}});
-    generateClosure(symtab,Productions,states[0]);
-    gotoTable.emplace_back();
-    for(size_t i = 0 ; i < states.size() ; i++) {
-        std::unordered_set<SymbolId> symclosure;
-        for(auto & dprod : states[i] ) {
-            const auto & prod = Productions.at(dprod.producId);
-            if(dprod.dot_pos < prod.rhs().size()) {
-                symclosure.insert(prod.rhs().at(dprod.dot_pos));
-            }
-        }
-        for(auto & symid : symclosure) {
-            auto nSt = generateState(symtab,Productions,states[i],symid);
-            processNewStateGOTO(states, gotoTable, symtab, Productions , nSt , StateId(i),symid);
-        }
-    }
+    buildLR0Automaton(symtab,Productions,pres.index(),states,gotoTable);
     
     std::cout<<"print STATE ---------------\n";
     for(size_t i = 0; i < states.size(); i++) {
@@ -698,13 +1318,166 @@ void parserGen_test_main() {
         std::cout<<std::endl;
     }
     std::vector<ForceReducedProd> forceReducedProd;
-    forceReducedProd = LCMPFileIO::parseProdFileR("C:/code/CPP/Compiler-Lab/grammar/SLR1ConflictReslove.txt");
-    bool success = generateSLRTable(states,actionTable,gotoTable,symtab,Productions,forceReducedProd,FOLLOW,NonTerminalId(symtab.find_index(u8"START").value()));
+    forceReducedProd = LCMPFileIO::parseProdFileR(rpath);
+    auto slrLookahead = followLookaheads(symtab,bits,follow);
+    LookaheadFn slrFn = [&slrLookahead](StateId, const Production & prod) -> const std::vector<SymbolId> & {
+        return slrLookahead.at(prod.lhs());
+    };
+    generateLRTable(states,actionTable,gotoTable,symtab,Productions,forceReducedProd,precedence,slrFn,NonTerminalId(symtab.find_index(u8"START").value()));
     
 }
 
+/**
+ * @brief 在临时目录中写出几组小文法并生成分析表：多线程与串行构造的结果逐字节相同，
+ *        LR(1)能分析LALR(1)因合并状态而出错的文法，优先级声明决定归约顺序
+ */
+int parserGen_test_main_tables() {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / "lcmp_parserGen_test";
+    fs::create_directories(dir);
+    auto writeFile = [&dir](const std::string & name, const std::string & text) {
+        std::ofstream(dir / name,std::ios::binary | std::ios::trunc) << text;
+        return dir / name;
+    };
+    //生成过程的状态与冲突输出不进入测试结果
+    auto generate = [](const fs::path & grammar, const fs::path & terminals, LRMode mode, size_t threads) {
+        std::streambuf * out = std::cout.rdbuf(nullptr);
+        std::streambuf * err = std::cerr.rdbuf(nullptr);
+        //产生式编号取自全局计数，每次生成前清零
+        LCMPFileIO::JsonConverter::productionCounter() = 0;
+        ASTbaseContent ret;
+        try {
+            ret = parserGen(grammar,terminals,std::nullopt,mode,threads);
+        }
+        catch(...) {
+            std::cout.rdbuf(out);
+            std::cerr.rdbuf(err);
+            throw;
+        }
+        std::cout.rdbuf(out);
+        std::cerr.rdbuf(err);
+        std::cout.clear();
+        std::cerr.clear();
+        return ret;
+    };
+    //按ACTION/GOTO表分析一串终结符，接受时返回依次归约的产生式
+    auto parse = [](const ASTbaseContent & c, const std::vector<std::u8string> & input) -> std::optional<std::vector<std::u8string>> {
+        std::vector<StateId> stack = {StateId(0)};
+        std::vector<std::u8string> reduced;
+        size_t i = 0;
+        while(true) {
+            auto sym = c.symtab.find_index(i < input.size() ? input[i] : u8"$");
+            if(!sym) return std::nullopt;
+            const auto & row = c.actionTable[stack.back()];
+            auto it = row.find(sym.value());
+            if(it == row.end()) return std::nullopt;
+            if(std::holds_alternative<StateId>(it->second)) {
+                stack.push_back(std::get<StateId>(it->second));
+                i++;
+                continue;
+            }
+            const Production & prod = c.Productions.at(std::get<ProductionId>(it->second));
+            if(c.symtab[prod.lhs()].sym() == u8"START") return reduced;
+            stack.resize(stack.size() - prod.rhs().size());
+            auto next = c.gotoTable[stack.back()].find(SymbolId(prod.lhs()));
+            if(next == c.gotoTable[stack.back()].end()) return std::nullopt;
+            stack.push_back(next->second);
+            reduced.push_back(LCMPFileIO::formatProduction(prod,c.symtab));
+        }
+    };
+    int failures = 0;
+    auto expect = [&failures](bool ok, const std::string & what) {
+        if(!ok) {
+            std::cerr<<"parserGen_test_main_tables: "<<what<<"\n";
+            failures++;
+        }
+    };
+
+    //多份互不相干的表达式文法，首波即有上百个状态，足以分给多个线程
+    {
+        constexpr int copies = 160;
+        std::string terminals = "\"ADD\",\"+\"\n\"MUL\",\"*\"\n\"LPA\",\"(\"\n\"RPA\",\")\"\n\"ID\",\"id\"\n";
+        std::string program = "Program ->";
+        std::string rules;
+        for(int k = 0 ; k < copies ; k++) {
+            const std::string n = std::to_string(k);
+            terminals += "\"KW" + n + "\",\"kw" + n + "\"\n";
+            program += (k == 0 ? " S_" : " | S_") + n;
+            rules += "S_" + n + " -> kw" + n + " E_" + n + "\n"
+                   + "E_" + n + " -> E_" + n + " + T_" + n + " | T_" + n + "\n"
+                   + "T_" + n + " -> T_" + n + " * F_" + n + " | F_" + n + "\n"
+                   + "F_" + n + " -> ( E_" + n + " ) | id\n";
+        }
+        const auto tpath = writeFile("waves_terminal.txt",terminals);
+        //原文法、新增候选式、删去一个非终结符、加入优先级声明
+        std::string removed = rules;
+        removed.replace(removed.find("E_1 -> E_1 + T_1 | T_1"),22,"E_1 -> E_1 + F_1 | F_1");
+        removed.erase(removed.find("T_1 -> "),removed.find('\n',removed.find("T_1 -> ")) - removed.find("T_1 -> ") + 1);
+        const std::vector<std::pair<std::string,std::string>> variants = {
+            {"base",program + "\n" + rules},
+            {"alternative",program + "\n" + rules + "F_0 -> id ( E_0 )\n"},
+            {"removed",program + "\n" + removed},
+            {"precedence",program + "\n" + rules + "%left +\n%left *\n"},
+        };
+        for(const auto & [name,text] : variants) {
+            const auto gpath = writeFile("waves_" + name + ".txt",text);
+            for(LRMode mode : {LRMode::SLR1,LRMode::LALR1}) {
+                const std::string serial = nlohmann::json(generate(gpath,tpath,mode,1)).dump();
+                const std::string parallel = nlohmann::json(generate(gpath,tpath,mode,4)).dump();
+                expect(serial == parallel,name + ": -j=4与-j=1生成的分析表不同");
+            }
+        }
+    }
+
+    //LALR(1)合并 a e / b e 后的状态出现归约-归约冲突，LR(1)不合并
+    {
+        const auto tpath = writeFile("lr1_terminal.txt","\"A\",\"a\"\n\"B\",\"b\"\n\"C\",\"c\"\n\"D\",\"d\"\n\"E\",\"e\"\n");
+        const auto gpath = writeFile("lr1_grammar.txt","S -> a E c | a F d | b F c | b E d\nE -> e\nF -> e\n");
+        const auto lalr = generate(gpath,tpath,LRMode::LALR1,1);
+        const auto lr1 = generate(gpath,tpath,LRMode::LR1,1);
+        const std::vector<std::vector<std::u8string>> sentences = {
+            {u8"a",u8"e",u8"c"},{u8"a",u8"e",u8"d"},{u8"b",u8"e",u8"c"},{u8"b",u8"e",u8"d"},
+        };
+        bool lalrAll = true;
+        for(const auto & s : sentences) {
+            expect(parse(lr1,s).has_value(),"LR(1)分析表拒绝了 " + toString(s[0] + s[1] + s[2]));
+            lalrAll = lalrAll && parse(lalr,s).has_value();
+        }
+        expect(!lalrAll,"LALR(1)分析表应无法区分 a e c / b e c 中的归约");
+        expect(lr1.states.size() > lalr.states.size(),"LR(1)状态数应多于LALR(1)");
+    }
+
+    //优先级与结合性
+    {
+        const auto tpath = writeFile("prec_terminal.txt","\"ADD\",\"+\"\n\"MUL\",\"*\"\n\"ROP\",\"rop\"\n\"ID\",\"id\"\n");
+        const std::string rules = "E -> E + E | E * E | E rop E | id\n";
+        const auto left = generate(writeFile("prec_left.txt",rules + "%nonassoc rop\n%left +\n%left *\n"),tpath,LRMode::SLR1,1);
+        const auto right = generate(writeFile("prec_right.txt",rules + "%nonassoc rop\n%right +\n%left *\n"),tpath,LRMode::SLR1,1);
+        const std::u8string id = u8"[E -> id]", add = u8"[E -> E + E]", mul = u8"[E -> E * E]";
+        expect(parse(left,{u8"id",u8"+",u8"id",u8"*",u8"id"}) == std::vector<std::u8string>{id,id,id,mul,add},"* 应先于 + 归约");
+        expect(parse(left,{u8"id",u8"*",u8"id",u8"+",u8"id"}) == std::vector<std::u8string>{id,id,mul,id,add},"* 应先于 + 归约");
+        expect(parse(left,{u8"id",u8"+",u8"id",u8"+",u8"id"}) == std::vector<std::u8string>{id,id,add,id,add},"%left + 应左结合");
+        expect(parse(right,{u8"id",u8"+",u8"id",u8"+",u8"id"}) == std::vector<std::u8string>{id,id,id,add,add},"%right + 应右结合");
+        expect(parse(left,{u8"id",u8"rop",u8"id"}).has_value(),"a rop b 应被接受");
+        expect(!parse(left,{u8"id",u8"rop",u8"id",u8"rop",u8"id"}).has_value(),"%nonassoc rop 不应接受连续比较");
+        bool thrown = false;
+        try {
+            generate(writeFile("prec_bad.txt",rules + "%left plus\n"),tpath,LRMode::SLR1,1);
+        }
+        catch(const std::runtime_error &) {
+            thrown = true;
+        }
+        expect(thrown,"未知终结符的优先级声明应报错");
+    }
+
+    fs::remove_all(dir);
+    if(failures) return 1;
+    std::cout<<"parserGen_test_main_tables: ok\n";
+    return 0;
+}
+
 
-ASTbaseContent parserGen(std::filesystem::path grammarFile , std::filesystem::path terminalsFile ,std::optional<std::filesystem::path> SLRruleFile) {
+ASTbaseContent parserGen(std::filesystem::path grammarFile , std::filesystem::path terminalsFile ,std::optional<std::filesystem::path> SLRruleFile, LRMode mode, size_t threadCount) {
     ASTbaseContent ret;
 
     std::unordered_map<ProductionId,Production> Productions;
@@ -714,6 +1487,7 @@ ASTbaseContent parserGen(std::filesystem::path grammarFile , std::filesystem::pa
     SymbolTable symtab;
 
     std::vector<Production> mproductions;
+    PrecedenceTable precedence;
     try {
         readTerminals(symtab,terminalsFile);
         readProductionRule(symtab,mproductions,grammarFile);
@@ -722,6 +1496,8 @@ ASTbaseContent parserGen(std::filesystem::path grammarFile , std::filesystem::pa
         std::cerr << "read grammar failed: " ;
         std::cerr << e.what() << '\n';
     }
+    //优先级声明有误时不能继续：冲突会改按默认移进消解，悄悄生成另一张表
+    precedence = readPrecedence(symtab,grammarFile);
     symtab.add_symbol(u8"START",u8"START",u8"",false);
     symtab.add_symbol(u8"$",u8"END",u8"",true);
     //增广文法
@@ -730,30 +1506,53 @@ ASTbaseContent parserGen(std::filesystem::path grammarFile , std::filesystem::pa
     for(auto & prod : mproductions) {
         Productions.insert({ProductionId(prod.index()),prod});
     }
-    auto FIRST = computeFirst(symtab,Productions);
-    auto FOLLOW = computeFollow(symtab,Productions,FIRST,symtab.nonTerminals().front());
+    const TerminalBits bits(symtab);
+    const auto nullable = computeNullable(symtab.symbols().size(),Productions);
+    const auto first = computeFirstSets(symtab,Productions,bits,nullable);
+    const auto follow = computeFollowSets(symtab,Productions,bits,nullable,first,symtab.nonTerminals().front());
 
-    states.emplace_back(std::vector<dotProdc>{{0,pres.index()}});
-    generateClosure(symtab,Productions,states[0]);
-    gotoTable.emplace_back();
-    for(size_t i = 0 ; i < states.size() ; i++) {
-        std::unordered_set<SymbolId> symclosure;
-        for(auto & dprod : states[i] ) {
-            const auto & prod = Productions.at(dprod.producId);
-            if(dprod.dot_pos < prod.rhs().size()) {
-                symclosure.insert(prod.rhs().at(dprod.dot_pos));
-            }
-        }
-        for(auto & symid : symclosure) {
-            auto nSt = generateState(symtab,Productions,states[i],symid);
-            processNewStateGOTO(states, gotoTable, symtab, Productions , nSt , StateId(i),symid);
-        }
+    if(threadCount == 1) {
+        buildLR0Automaton(symtab,Productions,pres.index(),states,gotoTable);
+    }
+    else {
+        buildLR0AutomatonParallel(symtab,Productions,pres.index(),states,gotoTable,threadCount);
     }
 
     std::vector<ForceReducedProd> forceReducedProd;
     if(SLRruleFile.has_value())
         forceReducedProd = LCMPFileIO::parseProdFileR(SLRruleFile.value());
-    bool success = generateSLRTable(states,actionTable,gotoTable,symtab,Productions,forceReducedProd,FOLLOW,NonTerminalId(symtab.find_index(u8"START").value()));
+    const NonTerminalId startId = NonTerminalId(symtab.find_index(u8"START").value());
+    auto slrLookahead = followLookaheads(symtab,bits,follow);
+    LookaheadFn slrFn = [&slrLookahead](StateId, const Production & prod) -> const std::vector<SymbolId> & {
+        return slrLookahead.at(prod.lhs());
+    };
+    if(mode == LRMode::SLR1) {
+        generateLRTable(states,actionTable,gotoTable,symtab,Productions,forceReducedProd,precedence,slrFn,startId);
+    }
+    else {
+        //同一组LR(0)状态上先静默生成SLR(1)表作对照
+        std::vector<std::unordered_map<SymbolId, action>> slrTable;
+        TableStats slr = generateLRTable(states,slrTable,gotoTable,symtab,Productions,forceReducedProd,precedence,slrFn,startId,false);
+        const size_t slrStates = states.size();
+        std::vector<std::unordered_map<ProductionId, std::vector<SymbolId>>> LA;
+        if(mode == LRMode::LALR1) {
+            LA = computeLALRLookaheads(symtab,Productions,states,gotoTable,startId);
+        }
+        else {
+            LA = buildLR1Automaton(symtab,Productions,pres.index(),true,states,gotoTable);
+        }
+        LookaheadFn lrFn = [&LA](StateId state, const Production & prod) -> const std::vector<SymbolId> & {
+            return LA[state].at(prod.index());
+        };
+        TableStats lr = generateLRTable(states,actionTable,gotoTable,symtab,Productions,forceReducedProd,precedence,lrFn,startId);
+        std::cout << (mode == LRMode::LALR1 ? "LALR(1)" : "LR(1)(Pager合并)")
+                  << ": 状态 " << states.size() << " (SLR(1) " << slrStates << ")"
+                  << " , 冲突 " << lr.conflicts << " (SLR(1) " << slr.conflicts << " , 消除 " << slr.conflicts - lr.conflicts << ")"
+                  << " , 未消解 " << lr.unresolved << " (SLR(1) " << slr.unresolved << ")"
+                  << " , 强制归约 " << lr.forcedReduce << " (SLR(1) " << slr.forcedReduce << ")"
+                  << " , 优先级消解 " << lr.precedence << " (SLR(1) " << slr.precedence << ")"
+                  << " , 归约表项 " << lr.reduceEntries << " (SLR(1) " << slr.reduceEntries << ")\n";
+    }
 
 
     std::cout<<"print STATE ---------------\n";
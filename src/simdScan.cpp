@@ -0,0 +1,217 @@
+#include"simdScan.h"
+#include<bit>
+#include<cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define LCMP_SIMD_X86 1
+#include<immintrin.h>
+#ifdef _MSC_VER
+#include<intrin.h>
+#endif
+#endif
+
+//MSVC无需target属性即可使用AVX2指令
+#if defined(LCMP_SIMD_X86) && !defined(_MSC_VER)
+#define LCMP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LCMP_TARGET_AVX2
+#endif
+
+namespace SimdScan
+{
+
+namespace {
+
+enum class ByteClass {
+    Space,
+    Digit,
+    Alnum,
+};
+
+template<ByteClass C>
+inline bool inClass(uint8_t c) {
+    if constexpr (C == ByteClass::Space) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    } else if constexpr (C == ByteClass::Digit) {
+        return '0' <= c && c <= '9';
+    } else {
+        uint8_t lower = c | 0x20;
+        return ('0' <= c && c <= '9') || ('a' <= lower && lower <= 'z');
+    }
+}
+
+template<ByteClass C>
+size_t skipScalar(std::u8string_view input, size_t pos) {
+    while(pos < input.size() && inClass<C>(static_cast<uint8_t>(input[pos]))) {
+        pos++;
+    }
+    return pos;
+}
+
+#ifdef LCMP_SIMD_X86
+
+//有符号比较即可：>=0x80的字节为负数，不会落入ASCII区间
+template<ByteClass C>
+inline __m128i match128(__m128i v) {
+    if constexpr (C == ByteClass::Space) {
+        __m128i m = _mm_cmpeq_epi8(v,_mm_set1_epi8(' '));
+        m = _mm_or_si128(m,_mm_cmpeq_epi8(v,_mm_set1_epi8('\t')));
+        m = _mm_or_si128(m,_mm_cmpeq_epi8(v,_mm_set1_epi8('\r')));
+        return _mm_or_si128(m,_mm_cmpeq_epi8(v,_mm_set1_epi8('\n')));
+    } else {
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v,_mm_set1_epi8('0' - 1)),
+                                      _mm_cmplt_epi8(v,_mm_set1_epi8('9' + 1)));
+        if constexpr (C == ByteClass::Digit) {
+            return digit;
+        } else {
+            __m128i lower = _mm_or_si128(v,_mm_set1_epi8(0x20));
+            __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower,_mm_set1_epi8('a' - 1)),
+                                          _mm_cmplt_epi8(lower,_mm_set1_epi8('z' + 1)));
+            return _mm_or_si128(digit,alpha);
+        }
+    }
+}
+
+template<ByteClass C>
+size_t skipSSE2(std::u8string_view input, size_t pos) {
+    const char8_t * data = input.data();
+    while(pos + 16 <= input.size()) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        uint32_t miss = ~static_cast<uint32_t>(_mm_movemask_epi8(match128<C>(v))) & 0xFFFFu;
+        if(miss) {
+            return pos + std::countr_zero(miss);
+        }
+        pos += 16;
+    }
+    return skipScalar<C>(input,pos);
+}
+
+template<ByteClass C>
+LCMP_TARGET_AVX2 inline __m256i match256(__m256i v) {
+    if constexpr (C == ByteClass::Space) {
+        __m256i m = _mm256_cmpeq_epi8(v,_mm256_set1_epi8(' '));
+        m = _mm256_or_si256(m,_mm256_cmpeq_epi8(v,_mm256_set1_epi8('\t')));
+        m = _mm256_or_si256(m,_mm256_cmpeq_epi8(v,_mm256_set1_epi8('\r')));
+        return _mm256_or_si256(m,_mm256_cmpeq_epi8(v,_mm256_set1_epi8('\n')));
+    } else {
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v,_mm256_set1_epi8('0' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1),v));
+        if constexpr (C == ByteClass::Digit) {
+            return digit;
+        } else {
+            __m256i lower = _mm256_or_si256(v,_mm256_set1_epi8(0x20));
+            __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower,_mm256_set1_epi8('a' - 1)),
+                                             _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1),lower));
+            return _mm256_or_si256(digit,alpha);
+        }
+    }
+}
+
+template<ByteClass C>
+LCMP_TARGET_AVX2 size_t skipAVX2(std::u8string_view input, size_t pos) {
+    const char8_t * data = input.data();
+    while(pos + 32 <= input.size()) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+        uint32_t miss = ~static_cast<uint32_t>(_mm256_movemask_epi8(match256<C>(v)));
+        if(miss) {
+            return pos + std::countr_zero(miss);
+        }
+        pos += 32;
+    }
+    return skipSSE2<C>(input,pos);
+}
+
+#endif // LCMP_SIMD_X86
+
+using SkipFn = size_t (*)(std::u8string_view, size_t);
+
+struct Dispatch {
+    Level level;
+    SkipFn space;
+    SkipFn digit;
+    SkipFn alnum;
+};
+
+Dispatch makeDispatch(Level lv) {
+#ifdef LCMP_SIMD_X86
+    if(lv == Level::AVX2) {
+        return {lv, skipAVX2<ByteClass::Space>, skipAVX2<ByteClass::Digit>, skipAVX2<ByteClass::Alnum>};
+    }
+    if(lv == Level::SSE2) {
+        return {lv, skipSSE2<ByteClass::Space>, skipSSE2<ByteClass::Digit>, skipSSE2<ByteClass::Alnum>};
+    }
+#endif
+    return {Level::Scalar, skipScalar<ByteClass::Space>, skipScalar<ByteClass::Digit>, skipScalar<ByteClass::Alnum>};
+}
+
+Level detect() {
+#ifdef LCMP_SIMD_X86
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info,0);
+    if(info[0] >= 7) {
+        __cpuidex(info,7,0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        __cpuid(info,1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        //操作系统需保存YMM寄存器
+        if(avx2 && osxsave && (_xgetbv(0) & 0x6) == 0x6) {
+            return Level::AVX2;
+        }
+    }
+    return Level::SSE2;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? Level::AVX2 : Level::SSE2;
+#endif
+#else
+    return Level::Scalar;
+#endif
+}
+
+Dispatch & active() {
+    static Dispatch d = makeDispatch(detectedLevel());
+    return d;
+}
+
+} // namespace
+
+
+Level detectedLevel() {
+    static const Level lv = detect();
+    return lv;
+}
+
+Level level() {
+    return active().level;
+}
+
+void setLevel(Level lv) {
+    if(static_cast<int>(lv) > static_cast<int>(detectedLevel())) {
+        lv = detectedLevel();
+    }
+    active() = makeDispatch(lv);
+}
+
+const char * levelName(Level lv) {
+    switch (lv)
+    {
+    case Level::AVX2: return "AVX2";
+    case Level::SSE2: return "SSE2";
+    default: return "Scalar";
+    }
+}
+
+size_t skipSpace(std::u8string_view input, size_t pos) {
+    return active().space(input,pos);
+}
+
+size_t skipDigit(std::u8string_view input, size_t pos) {
+    return active().digit(input,pos);
+}
+
+size_t skipAlnum(std::u8string_view input, size_t pos) {
+    return active().alnum(input,pos);
+}
+
+} // namespace SimdScan
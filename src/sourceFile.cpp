@@ -0,0 +1,135 @@
+#include"sourceFile.h"
+#include<stdexcept>
+#include<cstdio>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include<windows.h>
+#include<io.h>
+#include<fcntl.h>
+#else
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<cerrno>
+#endif
+
+namespace LCMPFileIO
+{
+
+namespace {
+
+[[noreturn]] void openError(const std::filesystem::path & path) {
+    throw std::runtime_error("无法打开文件: " + path.string());
+}
+
+} // namespace
+
+std::shared_ptr<const SourceFile> SourceFile::fromString(std::u8string text) {
+    std::shared_ptr<SourceFile> ret(new SourceFile());
+    ret->owned_ = std::move(text);
+    ret->view_ = ret->owned_;
+    return ret;
+}
+
+std::shared_ptr<const SourceFile> SourceFile::fromStdin() {
+#ifdef _WIN32
+    _setmode(_fileno(stdin),_O_BINARY);
+#endif
+    std::u8string text;
+    char8_t buf[1 << 16];
+    size_t n;
+    while((n = std::fread(buf,1,sizeof(buf),stdin)) > 0) {
+        text.append(buf,n);
+    }
+    if(std::ferror(stdin)) {
+        throw std::runtime_error("读取标准输入失败");
+    }
+    return fromString(std::move(text));
+}
+
+#ifdef _WIN32
+
+std::shared_ptr<const SourceFile> SourceFile::open(const std::filesystem::path & path) {
+    if(path == "-") return fromStdin();
+    HANDLE file = CreateFileW(path.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,nullptr);
+    if(file == INVALID_HANDLE_VALUE) openError(path);
+    std::shared_ptr<SourceFile> ret(new SourceFile());
+    LARGE_INTEGER size{};
+    if(GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file,&size) && size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingW(file,nullptr,PAGE_READONLY,0,0,nullptr);
+        void * view = mapping ? MapViewOfFile(mapping,FILE_MAP_READ,0,0,0) : nullptr;
+        if(view) {
+            ret->mapping_ = view;
+            ret->mappingHandle_ = mapping;
+            ret->mappedBytes_ = static_cast<size_t>(size.QuadPart);
+            ret->view_ = std::u8string_view(static_cast<const char8_t *>(view),ret->mappedBytes_);
+            CloseHandle(file);
+            return ret;
+        }
+        if(mapping) CloseHandle(mapping);
+    }
+    //管道等不可映射的句柄，整体读入一次
+    char8_t buf[1 << 16];
+    DWORD n = 0;
+    while(ReadFile(file,buf,sizeof(buf),&n,nullptr) && n > 0) {
+        ret->owned_.append(buf,n);
+    }
+    CloseHandle(file);
+    ret->view_ = ret->owned_;
+    return ret;
+}
+
+SourceFile::~SourceFile() {
+    if(mapping_) UnmapViewOfFile(mapping_);
+    if(mappingHandle_) CloseHandle(mappingHandle_);
+}
+
+#else
+
+std::shared_ptr<const SourceFile> SourceFile::open(const std::filesystem::path & path) {
+    if(path == "-") return fromStdin();
+    int fd = ::open(path.c_str(),O_RDONLY | O_CLOEXEC);
+    if(fd < 0) openError(path);
+    std::shared_ptr<SourceFile> ret(new SourceFile());
+    struct stat st{};
+    if(fstat(fd,&st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        size_t bytes = static_cast<size_t>(st.st_size);
+        void * view = mmap(nullptr,bytes,PROT_READ,MAP_PRIVATE,fd,0);
+        if(view != MAP_FAILED) {
+            //词法扫描从头到尾只读一遍，提示内核加大预读并及早回收已读页
+            madvise(view,bytes,MADV_SEQUENTIAL);
+            ret->mapping_ = view;
+            ret->mappedBytes_ = bytes;
+            ret->view_ = std::u8string_view(static_cast<const char8_t *>(view),bytes);
+            ::close(fd);
+            return ret;
+        }
+    }
+    //管道、字符设备等不可映射的输入，整体读入一次
+    char8_t buf[1 << 16];
+    while(true) {
+        ssize_t n = ::read(fd,buf,sizeof(buf));
+        if(n < 0 && errno == EINTR) continue;
+        if(n < 0) {
+            ::close(fd);
+            throw std::runtime_error("读取文件失败: " + path.string());
+        }
+        if(n == 0) break;
+        ret->owned_.append(buf,static_cast<size_t>(n));
+    }
+    ::close(fd);
+    ret->view_ = ret->owned_;
+    return ret;
+}
+
+SourceFile::~SourceFile() {
+    if(mapping_) munmap(mapping_,mappedBytes_);
+}
+
+#endif
+
+} // namespace LCMPFileIO
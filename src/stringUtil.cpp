@@ -1,5 +1,12 @@
 #include"stringUtil.h"
 #include<iostream>
+#include<cstring>
+#include<bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define LCMP_UTF8_SSE2 1
+#include<emmintrin.h>
+#endif
 
 std::vector<std::u8string> extract_utf8_chars(const std::u8string& str) {
     auto chars_view = utf8_chars_view(str);
@@ -11,12 +18,110 @@ std::vector<std::u8string> extract_utf8_chars(const std::u8string& str) {
     return res;
 }
 
+namespace {
+
+/**
+ * @brief 从i起跳过ASCII字节，返回第一个>=0x80字节的下标或n
+ */
+size_t skip_ascii(const uint8_t * p, size_t i, size_t n) {
+#ifdef LCMP_UTF8_SSE2
+    while(i + 64 <= n) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 48));
+        if(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a,b),_mm_or_si128(c,d))) != 0) break;
+        i += 64;
+    }
+    while(i + 16 <= n) {
+        uint32_t high = static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i))));
+        if(high) return i + std::countr_zero(high);
+        i += 16;
+    }
+#else
+    while(i + 8 <= n) {
+        uint64_t word;
+        std::memcpy(&word,p + i,8);
+        if(word & 0x8080808080808080ull) break;
+        i += 8;
+    }
+#endif
+    while(i < n && p[i] < 0x80) i++;
+    return i;
+}
+
+/**
+ * @brief 校验从i起的一个多字节序列，返回其长度，非法时返回0
+ */
+size_t utf8_seq_len(const uint8_t * p, size_t i, size_t n) {
+    uint8_t c = p[i];
+    size_t len;
+    uint8_t lo = 0x80;
+    uint8_t hi = 0xBF;
+    if(c < 0xC2) {
+        return 0;   //孤立的后续字节或过长的2字节编码
+    } else if(c < 0xE0) {
+        len = 2;
+    } else if(c < 0xF0) {
+        len = 3;
+        if(c == 0xE0) lo = 0xA0;    //过长编码
+        if(c == 0xED) hi = 0x9F;    //代理区
+    } else if(c < 0xF5) {
+        len = 4;
+        if(c == 0xF0) lo = 0x90;    //过长编码
+        if(c == 0xF4) hi = 0x8F;    //超出U+10FFFF
+    } else {
+        return 0;
+    }
+    if(i + len > n) return 0;
+    if(p[i+1] < lo || p[i+1] > hi) return 0;
+    for(size_t j = 2 ; j < len ; j++) {
+        if((p[i+j] & 0xC0) != 0x80) return 0;
+    }
+    return len;
+}
+
+} // namespace
+
+std::optional<size_t> validate_utf8(std::u8string_view str) {
+    const uint8_t * p = reinterpret_cast<const uint8_t *>(str.data());
+    const size_t n = str.size();
+    size_t i = 0;
+    while(true) {
+        i = skip_ascii(p,i,n);
+        if(i == n) break;
+        //非ASCII段逐字符校验，遇到ASCII再回到块扫描
+        while(i < n && p[i] >= 0x80) {
+            size_t len = utf8_seq_len(p,i,n);
+            if(len == 0) return i;
+            i += len;
+        }
+    }
+    return std::nullopt;
+}
+
 int string_test_main() {
     std::u8string text = u8"你好，世界！🌍";
     for (auto ch : utf8_chars_view(text)) {
         std::cout << toString(ch) << " ";
     }
     // 输出：你 好 ， 世 界 ！ 🌍
+    std::cout << "\n";
+    const std::vector<std::pair<std::u8string,std::optional<size_t>>> utf8Cases = {
+        {text,std::nullopt},
+        {std::u8string(100,u8'a') + u8"这是x",std::nullopt},
+        {u8"ab\xC0\x80",2},           //过长编码
+        {u8"abc\xED\xA0\x80",3},      //代理区
+        {u8"abcd\xF4\x90\x80\x80",4}, //超出U+10FFFF
+        {u8"中\xE4\xB8",3},            //截断
+        {std::u8string(70,u8' ') + u8"\x80",70},
+    };
+    for(auto & [input,expect] : utf8Cases) {
+        if(validate_utf8(input) != expect) {
+            std::cout << "validate_utf8 mismatch: " << toString(input) << "\n";
+            return 1;
+        }
+    }
     return 0;
 }
 
@@ -0,0 +1,51 @@
+#include<iostream>
+#include<filesystem>
+#include<optional>
+#include"parserGen.h"
+#include"parseTableFile.h"
+
+/**
+ * @brief 作用域内丢弃流的输出，离开时恢复
+ */
+class MuteStream {
+public:
+    explicit MuteStream(std::ostream & os) : os_(os), buf_(os.rdbuf(nullptr)) {}
+    ~MuteStream() { os_.rdbuf(buf_); os_.clear(); }
+private:
+    std::ostream & os_;
+    std::streambuf * buf_;
+};
+
+/**
+ * @brief 构建时生成默认文法的分析表头文件，及可选的直接编码分析器头文件
+ * @note 用法: LCTableGen <grammar文件> <terminal文件> <SLR冲突解决文件> <分析表头文件> [<直接编码分析器头文件>]
+ */
+int main(int argc, const char* argv[]) {
+    if(argc != 5 && argc != 6) {
+        std::cerr<<"用法: LCTableGen <grammar文件> <terminal文件> <SLR冲突解决文件> <分析表头文件> [<直接编码分析器头文件>]\n";
+        return 1;
+    }
+    try {
+        ASTbaseContent astbase;
+        {
+            //生成过程的提示与冲突报告不进入构建输出
+            MuteStream muteOut(std::cout), muteErr(std::cerr);
+            astbase = parserGen(argv[1],argv[2],std::filesystem::path(argv[3]));
+        }
+        if(astbase.actionTable.empty() || astbase.Productions.empty()) {
+            std::cerr<<"LCTableGen: 无法由"<<argv[1]<<"生成分析表\n";
+            return 1;
+        }
+        auto packed = ParseTable::build(astbase.actionTable,astbase.gotoTable,astbase.symtab,astbase.Productions);
+        const uint64_t hash = LCMPFileIO::grammarHash(argv[1],argv[2],std::filesystem::path(argv[3]),LRMode::SLR1);
+        LCMPFileIO::writeParseTableHeader(astbase,packed,hash,argv[4],"DefaultParseTable");
+        if(argc == 6) {
+            LCMPFileIO::writeDirectParserHeader(astbase,packed,hash,argv[5],"DefaultDirectParser");
+        }
+    }
+    catch(const std::exception & e) {
+        std::cerr<<"LCTableGen: "<<e.what()<<"\n";
+        return 1;
+    }
+    return 0;
+}